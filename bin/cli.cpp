@@ -20,6 +20,21 @@ int main(int argc, char** argv) {
     transform->add_option("--output-path", transform_args.output_path, "Path to output file.")->required();
     transform->add_option("--output-format", transform_args.output_format, "Output format.")->required();
     transform->add_option("--schema-path", transform_args.schema_path, "Schema for columnar format.");
+    transform->add_option("--use-arena", transform_args.use_arena, "Allocate decoded documents from a per-read arena.")->default_val(true);
+    transform->add_option("--compact-values", transform_args.compact_values, "Pass documents in compact 16-byte value representation.")->default_val(false);
+    transform->add_option("--zero-copy-strings", transform_args.zero_copy_strings, "Reference strings of mmapped input instead of copying them. Implies arena.")->default_val(false);
+    transform->add_option("--batch-size", transform_args.batch_size, "Number of documents decoded and encoded at once.")->default_val(1024);
+    transform->add_option("--parse-threads", transform_args.parse_threads, "Number of threads parsing JSON or assembling columnar row groups.")->default_val(1);
+    transform->add_option("--io-backend", transform_args.io_backend, "How columnar input files are read: mmap, uring or threads.")->default_val("mmap");
+    transform->add_option("--io-depth", transform_args.io_depth, "Reads in flight at once with uring and threads I/O backends.")->default_val(32);
+    transform->add_option("--direct-io", transform_args.direct_io, "Read and write chunk files with O_DIRECT, bypassing the page cache.")->default_val(false);
+    transform->add_option("--pipeline", transform_args.pipeline, "Run reading, conversion and writing on separate threads.")->default_val(false);
+    transform->add_option("--queue-capacity", transform_args.queue_capacity, "Number of batches buffered between pipeline stages.")->default_val(4);
+    transform->add_option("--durability", transform_args.durability, "Wait for output on disk (full), only start writeback (async) or neither (none).")->default_val("full");
+    transform->add_option("--columnar-layout", transform_args.columnar_layout, "Write columnar output as a directory of leaf files (directory) or a single file (file).")->default_val("directory");
+    transform->add_option("--split-float-bytes", transform_args.split_float_bytes, "Byte stream split columnar floating-point values that Gorilla encoding does not shrink, for output compressed afterwards.")->default_val(false);
+    transform->add_option("--row-group-size", transform_args.row_group_size, "Records per row group of single file columnar output, 0 for a single group.")->default_val(1 << 16);
+    transform->add_option("--raw-copy", transform_args.raw_copy, "Copy bson to bson with splice(2) without decoding or validating it. Input or output must be a pipe.")->default_val(false);
 
     cli::ReadArgs read_args;
     CLI::App* read = app.add_subcommand(
@@ -34,6 +49,14 @@ int main(int argc, char** argv) {
 
     read->add_option("--schema-path", read_args.schema_path, "Schema for columnar format.");
     read->add_option("--write-to-stdout", read_args.write_to_stdout, "Write output to stdout in JSONLINE format.")->default_val(false);
+    read->add_option("--use-arena", read_args.use_arena, "Allocate decoded documents from a per-read arena.")->default_val(true);
+    read->add_option("--compact-values", read_args.compact_values, "Read documents into compact 16-byte value representation.")->default_val(false);
+    read->add_option("--zero-copy-strings", read_args.zero_copy_strings, "Reference strings of mmapped input instead of copying them. Implies arena.")->default_val(false);
+    read->add_option("--batch-size", read_args.batch_size, "Number of documents decoded at once.")->default_val(1024);
+    read->add_option("--parse-threads", read_args.parse_threads, "Number of threads parsing JSON or assembling columnar row groups.")->default_val(1);
+    read->add_option("--io-backend", read_args.io_backend, "How columnar files are read: mmap, uring or threads.")->default_val("mmap");
+    read->add_option("--io-depth", read_args.io_depth, "Reads in flight at once with uring and threads I/O backends.")->default_val(32);
+    read->add_option("--direct-io", read_args.direct_io, "Read chunk files with O_DIRECT, bypassing the page cache.")->default_val(false);
 
     cli::DatasetGeneratorArgs dataset_generator_args;
     CLI::App* generate_dataset = app.add_subcommand(
@@ -0,0 +1,104 @@
+#include "allocations.h"
+
+#ifdef COUNT_ALLOCATIONS
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace cli {
+
+namespace {
+
+    std::atomic<std::size_t> allocations_count{0};
+
+    void* CountedAllocate(std::size_t size) {
+        allocations_count.fetch_add(1, std::memory_order_relaxed);
+        if (size == 0) {
+            size = 1;
+        }
+        if (void* ptr = std::malloc(size)) {
+            return ptr;
+        }
+        throw std::bad_alloc();
+    }
+
+    // aligned_alloc wants the size to be a multiple of the alignment.
+    void* CountedAllocate(std::size_t size, std::align_val_t alignment) {
+        allocations_count.fetch_add(1, std::memory_order_relaxed);
+        const auto align = static_cast<std::size_t>(alignment);
+        size = (std::max<std::size_t>(size, 1) + align - 1) / align * align;
+        if (void* ptr = std::aligned_alloc(align, size)) {
+            return ptr;
+        }
+        throw std::bad_alloc();
+    }
+
+} // namespace
+
+std::size_t GetAllocationsCount() {
+    return allocations_count.load(std::memory_order_relaxed);
+}
+
+} // namespace cli
+
+void* operator new(std::size_t size) {
+    return cli::CountedAllocate(size);
+}
+
+void* operator new[](std::size_t size) {
+    return cli::CountedAllocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return cli::CountedAllocate(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return cli::CountedAllocate(size, alignment);
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+#else
+
+namespace cli {
+
+std::size_t GetAllocationsCount() {
+    return 0;
+}
+
+} // namespace cli
+
+#endif
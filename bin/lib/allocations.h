@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+
+namespace cli {
+
+// Global operator new is replaced with a counting one only in builds
+// configured with -DCOUNT_ALLOCATIONS=ON, for benchmarks.
+#ifdef COUNT_ALLOCATIONS
+inline constexpr bool kCountsAllocations = true;
+#else
+inline constexpr bool kCountsAllocations = false;
+#endif
+
+// Number of heap allocations made by the process so far, 0 without counting.
+std::size_t GetAllocationsCount();
+
+} // namespace cli
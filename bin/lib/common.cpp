@@ -6,13 +6,13 @@
 
 namespace cli {
 
-std::shared_ptr<lib::chunk_impl::Chunk> GetChunk(std::string&& path, std::string&& format, std::string&& schema_path) {
+std::shared_ptr<lib::chunk_impl::Chunk> GetChunk(std::string&& path, std::string&& format, std::string&& schema_path, const lib::chunk_impl::ChunkOptions& options) {
     if (format == "json") {
-        return std::static_pointer_cast<lib::chunk_impl::Chunk>(std::make_shared<lib::chunk_impl::JsonChunk>(std::move(path)));
+        return std::static_pointer_cast<lib::chunk_impl::Chunk>(std::make_shared<lib::chunk_impl::JsonChunk>(std::move(path), options));
     } else if (format == "bson") {
-        return std::static_pointer_cast<lib::chunk_impl::Chunk>(std::make_shared<lib::chunk_impl::BsonChunk>(std::move(path)));
+        return std::static_pointer_cast<lib::chunk_impl::Chunk>(std::make_shared<lib::chunk_impl::BsonChunk>(std::move(path), options));
     } else if (format == "columnar") {
-        return std::static_pointer_cast<lib::chunk_impl::Chunk>(std::make_shared<lib::chunk_impl::ColumnarChunk>(std::move(path), std::move(schema_path)));
+        return std::static_pointer_cast<lib::chunk_impl::Chunk>(std::make_shared<lib::chunk_impl::ColumnarChunk>(std::move(path), std::move(schema_path), options));
     } else {
         throw std::runtime_error("Unknown chunk format, supported formats are [json, bson, columnar]");
     }
@@ -6,6 +6,6 @@
 
 namespace cli {
 
-std::shared_ptr<lib::chunk_impl::Chunk> GetChunk(std::string&& path, std::string&& format, std::string&& schema_path);
+std::shared_ptr<lib::chunk_impl::Chunk> GetChunk(std::string&& path, std::string&& format, std::string&& schema_path, const lib::chunk_impl::ChunkOptions& options = {});
 
 } // namespace cli
@@ -171,6 +171,7 @@ void RunGenerateDataset(DatasetGeneratorArgs&& args) {
         ostream->Write("\n", 1);
         std::cerr << "Generated " << i + 1 << '/' << args.docs_count << " documents\n";
     }
+    ostream->Close(lib::chunk_impl::Durability::Full);
 }
 
 void RunGenerateSchema(SchemaGeneratorArgs&& args) {
@@ -187,6 +188,7 @@ void RunGenerateSchema(SchemaGeneratorArgs&& args) {
 
     auto stream = lib::chunk_impl::GetOutputStream(args.output_path);
     stream->Write(buffer.GetString(), buffer.GetLength());
+    stream->Close(lib::chunk_impl::Durability::Full);
 }
 
 } // namespace cli
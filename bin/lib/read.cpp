@@ -4,6 +4,7 @@
 #include <iostream>
 #include <sstream>
 
+#include <bin/lib/allocations.h>
 #include <bin/lib/common.h>
 #include <lib/chunk_impl/io.h>
 
@@ -44,10 +45,11 @@ namespace {
         auto splited = SplitByDots(str);
 
         for (const auto& part : splited) {
-            if (node->children.find(part) == node->children.end()) {
-                node->children[part] = lib::chunk_impl::TreeNode::Default();
+            const auto key = lib::document::InternKey(part);
+            if (node->children.find(key) == node->children.end()) {
+                node->children[key] = lib::chunk_impl::TreeNode::Default();
             }
-            node = node->children[part];
+            node = node->children[key];
         }
     }
 
@@ -80,20 +82,65 @@ namespace {
 } // namespace
 
 void RunRead(ReadArgs&& args) {
-    const auto chunk = GetChunk(std::move(args.path), std::move(args.format), std::move(args.schema_path));
+    lib::chunk_impl::ChunkOptions options;
+    options.use_arena = args.use_arena;
+    options.zero_copy_strings = args.zero_copy_strings;
+    options.batch_size = args.batch_size;
+    options.parse_threads = args.parse_threads;
+    options.io_backend = lib::chunk_impl::ParseIoBackend(args.io_backend);
+    options.io_depth = args.io_depth;
+    options.direct_io = args.direct_io;
+
+    const auto chunk = GetChunk(std::move(args.path), std::move(args.format), std::move(args.schema_path), options);
     const auto columns_tree = BuildPrefixTree(std::move(args.columns), std::move(args.columns_file));
 
-    const auto start = std::chrono::high_resolution_clock::now();
-    const auto documents = chunk->Read(columns_tree);
-    const auto stop = std::chrono::high_resolution_clock::now();
-    const auto duration_read = std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start);
+    std::unique_ptr<lib::chunk_impl::ChunkWriter> writer;
+    if (args.write_to_stdout) {
+        writer = GetChunk("stdout", "json", "")->OpenWriter();
+    }
 
-    std::cerr << "{\"read_duration_ns\": " << duration_read.count() << "}\n";
+    // Only decoding is measured, batches are written to stdout and dropped in between.
+    auto allocations_before = GetAllocationsCount();
+    auto start = std::chrono::high_resolution_clock::now();
+    auto reader = chunk->OpenReader(columns_tree);
+    std::chrono::nanoseconds duration_read{0};
+    std::size_t allocations = 0;
+    while (true) {
+        std::vector<std::shared_ptr<lib::document::Document>> documents;
+        lib::document::CompactBatch compact_batch;
+        if (args.compact_values) {
+            compact_batch = reader->NextCompactBatch();
+        } else {
+            documents = reader->NextBatch();
+        }
+        const auto stop = std::chrono::high_resolution_clock::now();
+        duration_read += std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start);
+        allocations += GetAllocationsCount() - allocations_before;
 
-    if (args.write_to_stdout) {
-        const auto output_chunk = GetChunk("stdout", "json", "");
-        output_chunk->Write(documents);
+        const auto batch_size = args.compact_values ? compact_batch.documents.size() : documents.size();
+        if (batch_size == 0) {
+            break;
+        }
+        if (writer != nullptr) {
+            if (args.compact_values) {
+                writer->WriteCompactBatch(compact_batch);
+            } else {
+                writer->WriteBatch(documents);
+            }
+        }
+
+        allocations_before = GetAllocationsCount();
+        start = std::chrono::high_resolution_clock::now();
+    }
+    if (writer != nullptr) {
+        writer->Finish();
+    }
+
+    std::cerr << "{\"read_duration_ns\": " << duration_read.count();
+    if (kCountsAllocations) {
+        std::cerr << ", \"allocations\": " << allocations;
     }
+    std::cerr << "}\n";
 }
 
 } // namespace cli
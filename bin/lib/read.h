@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <string>
 
 namespace cli {
@@ -12,6 +13,14 @@ struct ReadArgs {
     std::string schema_path;
 
     bool write_to_stdout;
+    bool use_arena;
+    bool compact_values;
+    bool zero_copy_strings;
+    std::size_t batch_size;
+    std::size_t parse_threads;
+    std::string io_backend;
+    std::size_t io_depth;
+    bool direct_io;
 };
 
 void RunRead(ReadArgs&& args);
@@ -1,27 +1,259 @@
 #include "transform.h"
 
 #include <chrono>
+#include <exception>
+#include <filesystem>
 #include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
 
 #include <bin/lib/common.h>
+#include <lib/chunk_impl/bounded_queue.h>
+#include <lib/chunk_impl/io.h>
 
 namespace cli {
 
+namespace {
+
+    using Clock = std::chrono::high_resolution_clock;
+
+    std::chrono::nanoseconds Since(Clock::time_point start) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start);
+    }
+
+    struct Batch {
+        bool compact = false;
+        std::vector<std::shared_ptr<lib::document::Document>> documents;
+        lib::document::CompactBatch compact_batch;
+
+        bool Empty() const {
+            return compact ? compact_batch.documents.empty() : documents.empty();
+        }
+    };
+
+    Batch ReadBatch(lib::chunk_impl::ChunkReader& reader, bool compact) {
+        Batch batch;
+        batch.compact = compact;
+        if (compact) {
+            batch.compact_batch = reader.NextCompactBatch();
+        } else {
+            batch.documents = reader.NextBatch();
+        }
+        return batch;
+    }
+
+    void WriteBatch(lib::chunk_impl::ChunkWriter& writer, const Batch& batch) {
+        if (batch.compact) {
+            writer.WriteCompactBatch(batch.compact_batch);
+        } else {
+            writer.WriteBatch(batch.documents);
+        }
+    }
+
+    // Moves compact to regular documents, for writers that would convert anyway.
+    void ConvertBatch(Batch& batch, bool use_arena) {
+        batch.documents = lib::document::FromCompactBatch(batch.compact_batch, use_arena ? std::make_shared<lib::document::Arena>() : nullptr);
+        batch.compact_batch = {};
+        batch.compact = false;
+    }
+
+    struct StageStats {
+        std::chrono::nanoseconds busy{0};
+        // Time spent waiting on neighbour stages.
+        std::chrono::nanoseconds idle{0};
+    };
+
+    struct PipelineStats {
+        StageStats read;
+        StageStats convert;
+        StageStats write;
+    };
+
+    void RunSequential(lib::chunk_impl::ChunkReader& reader, lib::chunk_impl::ChunkWriter& writer, bool compact, PipelineStats& stats) {
+        while (true) {
+            auto start = Clock::now();
+            auto batch = ReadBatch(reader, compact);
+            stats.read.busy += Since(start);
+            if (batch.Empty()) {
+                break;
+            }
+
+            start = Clock::now();
+            WriteBatch(writer, batch);
+            stats.write.busy += Since(start);
+        }
+    }
+
+    // Reader and converter run on their own threads, writer runs on the calling
+    // thread. Stages are connected with bounded queues, so at most a few batches
+    // per queue are in flight. The first error stops all stages and is rethrown.
+    void RunPipelined(lib::chunk_impl::ChunkReader& reader, lib::chunk_impl::ChunkWriter& writer, const TransformArgs& args, PipelineStats& stats) {
+        const bool convert = args.compact_values && !writer.SupportsCompactBatches();
+        lib::chunk_impl::BoundedQueue<Batch> read_queue(args.queue_capacity);
+        lib::chunk_impl::BoundedQueue<Batch> convert_queue(args.queue_capacity);
+        auto& write_queue = convert ? convert_queue : read_queue;
+
+        std::mutex error_mutex;
+        std::exception_ptr error;
+        const auto fail = [&]() {
+            {
+                std::lock_guard lock(error_mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+            read_queue.Close();
+            convert_queue.Close();
+        };
+
+        std::thread read_thread([&]() {
+            try {
+                while (true) {
+                    auto start = Clock::now();
+                    auto batch = ReadBatch(reader, args.compact_values);
+                    stats.read.busy += Since(start);
+                    if (batch.Empty()) {
+                        break;
+                    }
+
+                    start = Clock::now();
+                    const bool pushed = read_queue.Push(std::move(batch));
+                    stats.read.idle += Since(start);
+                    if (!pushed) {
+                        break;
+                    }
+                }
+            } catch (...) {
+                fail();
+            }
+            read_queue.Close();
+        });
+
+        std::thread convert_thread;
+        if (convert) {
+            convert_thread = std::thread([&]() {
+                try {
+                    while (true) {
+                        auto start = Clock::now();
+                        auto batch = read_queue.Pop();
+                        stats.convert.idle += Since(start);
+                        if (!batch) {
+                            break;
+                        }
+
+                        start = Clock::now();
+                        ConvertBatch(*batch, args.use_arena);
+                        stats.convert.busy += Since(start);
+
+                        start = Clock::now();
+                        const bool pushed = convert_queue.Push(std::move(*batch));
+                        stats.convert.idle += Since(start);
+                        if (!pushed) {
+                            break;
+                        }
+                    }
+                } catch (...) {
+                    fail();
+                }
+                convert_queue.Close();
+            });
+        }
+
+        try {
+            while (true) {
+                auto start = Clock::now();
+                auto batch = write_queue.Pop();
+                stats.write.idle += Since(start);
+                if (!batch) {
+                    break;
+                }
+
+                start = Clock::now();
+                WriteBatch(writer, *batch);
+                stats.write.busy += Since(start);
+            }
+        } catch (...) {
+            fail();
+        }
+
+        read_thread.join();
+        if (convert_thread.joinable()) {
+            convert_thread.join();
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+} // namespace
+
 void RunTransform(TransformArgs&& args) {
-    const auto input_chunk = GetChunk(std::move(args.input_path), std::move(args.input_format), std::string(args.schema_path));
-    const auto output_chunk = GetChunk(std::move(args.output_path), std::move(args.output_format), std::move(args.schema_path));
+    // Re-encoding BSON reproduces its input byte for byte, so on request the
+    // data is only copied between pipes, without decoding or validating it.
+    if (args.raw_copy) {
+        if (args.input_format != "bson" || args.output_format != "bson") {
+            throw std::runtime_error("Raw copy is only supported from bson to bson");
+        }
+        const auto start = Clock::now();
+        lib::chunk_impl::CopyStream(args.input_path, args.output_path, lib::chunk_impl::ParseDurability(args.durability));
+        std::cerr << "{\"copy_duration_ns\": " << Since(start).count() << "}\n";
+        return;
+    }
+
+    lib::chunk_impl::ChunkOptions options;
+    options.use_arena = args.use_arena;
+    options.zero_copy_strings = args.zero_copy_strings;
+    options.batch_size = args.batch_size;
+    options.parse_threads = args.parse_threads;
+    options.io_backend = lib::chunk_impl::ParseIoBackend(args.io_backend);
+    options.io_depth = args.io_depth;
+    options.direct_io = args.direct_io;
+    options.durability = lib::chunk_impl::ParseDurability(args.durability);
+    options.columnar_layout = lib::chunk_impl::ParseColumnarLayout(args.columnar_layout);
+    options.split_float_bytes = args.split_float_bytes;
+    options.row_group_size = args.row_group_size;
+    // The output is usually about as large as the input.
+    std::error_code error;
+    if (std::filesystem::is_regular_file(args.input_path, error)) {
+        options.size_hint = std::filesystem::file_size(args.input_path, error);
+        if (error) {
+            options.size_hint = 0;
+        }
+    }
+
+    const auto input_chunk = GetChunk(std::move(args.input_path), std::move(args.input_format), std::string(args.schema_path), options);
+    const auto output_chunk = GetChunk(std::move(args.output_path), std::move(args.output_format), std::move(args.schema_path), options);
+
+    PipelineStats stats;
+    const auto wall_start = Clock::now();
+
+    auto start = Clock::now();
+    auto reader = input_chunk->OpenReader();
+    stats.read.busy += Since(start);
+
+    start = Clock::now();
+    auto writer = output_chunk->OpenWriter();
+    stats.write.busy += Since(start);
 
-    auto start = std::chrono::high_resolution_clock::now();
-    const auto documents = input_chunk->Read();
-    auto stop = std::chrono::high_resolution_clock::now();
-    const auto duration_read = std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start);
+    if (args.pipeline) {
+        RunPipelined(*reader, *writer, args, stats);
+    } else {
+        RunSequential(*reader, *writer, args.compact_values, stats);
+    }
 
-    start = std::chrono::high_resolution_clock::now();
-    output_chunk->Write(documents);
-    stop = std::chrono::high_resolution_clock::now();
-    const auto duration_write = std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start);
+    start = Clock::now();
+    writer->Finish();
+    stats.write.busy += Since(start);
 
-    std::cerr << "{\"read_duration_ns\": " << duration_read.count() << ", \"write_duration_ns\": " << duration_write.count() << "}\n";
+    if (args.pipeline) {
+        std::cerr << "{\"read_duration_ns\": " << stats.read.busy.count() << ", \"write_duration_ns\": " << stats.write.busy.count()
+                  << ", \"convert_duration_ns\": " << stats.convert.busy.count() << ", \"read_idle_ns\": " << stats.read.idle.count()
+                  << ", \"convert_idle_ns\": " << stats.convert.idle.count() << ", \"write_idle_ns\": " << stats.write.idle.count()
+                  << ", \"wall_duration_ns\": " << Since(wall_start).count() << "}\n";
+    } else {
+        std::cerr << "{\"read_duration_ns\": " << stats.read.busy.count() << ", \"write_duration_ns\": " << stats.write.busy.count() << "}\n";
+    }
 }
 
 } // namespace cli
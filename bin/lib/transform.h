@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <string>
 
 namespace cli {
@@ -10,6 +11,22 @@ struct TransformArgs {
     std::string output_path;
     std::string output_format;
     std::string schema_path;
+
+    bool use_arena;
+    bool compact_values;
+    bool zero_copy_strings;
+    std::size_t batch_size;
+    std::size_t parse_threads;
+    bool pipeline;
+    std::size_t queue_capacity;
+    std::string durability;
+    std::string io_backend;
+    std::size_t io_depth;
+    bool direct_io;
+    std::string columnar_layout;
+    bool split_float_bytes;
+    std::size_t row_group_size;
+    bool raw_copy;
 };
 
 void RunTransform(TransformArgs&& args);
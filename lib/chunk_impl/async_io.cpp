@@ -0,0 +1,458 @@
+#include "async_io.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unistd.h>
+
+#include <lib/chunk_impl/thread_pool.h>
+
+namespace lib::chunk_impl {
+
+namespace {
+
+    constexpr std::size_t kReadBlockSize = 1 << 20;
+    constexpr std::size_t kBufferAlignment = 4096;
+
+    struct OpenedFile {
+        std::string path;
+        int fd = -1;
+        bool direct = false;
+        std::size_t size = 0;
+    };
+
+    // Bytes read into one buffer. With O_DIRECT the read starts at an aligned
+    // offset, skip bytes before the wanted data.
+    struct ReadTarget {
+        std::size_t file;
+        std::size_t offset;
+        std::size_t size;
+        std::size_t skip;
+        AlignedBuffer buffer;
+    };
+
+    struct ReadRequest {
+        std::size_t file;
+        std::size_t offset;
+        std::size_t length;
+        iovec iov;
+    };
+
+    // Closes descriptors of opened files when reading fails half way.
+    class OpenedFiles {
+    public:
+        ~OpenedFiles() {
+            for (const auto& file : files) {
+                if (file.fd != -1) {
+                    close(file.fd);
+                }
+            }
+        }
+
+        std::vector<OpenedFile> files;
+    };
+
+    void Open(const std::string& path, bool direct, OpenedFile& file) {
+        file.path = path;
+        file.direct = direct;
+        file.fd = OpenFile(path.c_str(), O_RDONLY, file.direct);
+        if (file.fd == -1) {
+            throw std::runtime_error("Failed to open input file: " + path + " " + strerror(errno));
+        }
+        struct stat st;
+        if (fstat(file.fd, &st) == -1) {
+            throw std::runtime_error("Failed to determine file size: " + path + " " + strerror(errno));
+        }
+        file.size = st.st_size;
+    }
+
+    ReadTarget MakeTarget(const std::vector<OpenedFile>& files, std::size_t file, std::size_t offset, std::size_t length) {
+        if (offset + length > files[file].size) {
+            throw std::out_of_range("Read exceeds file size: " + files[file].path);
+        }
+        const auto start = files[file].direct ? offset / kBufferAlignment * kBufferAlignment : offset;
+        const auto size = offset - start + length;
+        return ReadTarget{file, start, size, offset - start, AllocateAligned(size, kBufferAlignment)};
+    }
+
+    // O_DIRECT reads whole blocks, buffers have room for the last one.
+    std::size_t ReadLength(const OpenedFile& file, std::size_t length) {
+        return file.direct ? (length + kBufferAlignment - 1) / kBufferAlignment * kBufferAlignment : length;
+    }
+
+    std::vector<ReadRequest> SplitIntoRequests(const std::vector<OpenedFile>& files, std::vector<ReadTarget>& targets) {
+        std::vector<ReadRequest> requests;
+        for (auto& target : targets) {
+            for (std::size_t offset = 0; offset < target.size; offset += kReadBlockSize) {
+                const auto length = std::min(kReadBlockSize, target.size - offset);
+                const auto iov = iovec{target.buffer.get() + offset, ReadLength(files[target.file], length)};
+                requests.push_back(ReadRequest{target.file, target.offset + offset, length, iov});
+            }
+        }
+        return requests;
+    }
+
+    // Accounts a completed read, the rest of a short read is left in request.
+    void Advance(ReadRequest& request, const OpenedFile& file, std::size_t read_bytes) {
+        if (read_bytes == 0) {
+            throw std::runtime_error("Unexpected end of file: " + file.path);
+        }
+        read_bytes = std::min(read_bytes, request.length);
+        request.offset += read_bytes;
+        request.length -= read_bytes;
+        request.iov.iov_base = static_cast<char*>(request.iov.iov_base) + read_bytes;
+        request.iov.iov_len = ReadLength(file, request.length);
+    }
+
+    // Shared by all pread(2) reads, so reads of every row group do not start
+    // threads of their own. Replaced by a larger pool when a caller asks for
+    // more threads, reads still running keep the old one alive until they end.
+    std::shared_ptr<ThreadPool> ReadPool(std::size_t threads_count) {
+        static std::mutex mutex;
+        static std::shared_ptr<ThreadPool> pool;
+        std::unique_lock lock(mutex);
+        if (!pool || pool->GetThreadsCount() < threads_count) {
+            pool = std::make_shared<ThreadPool>(threads_count);
+        }
+        return pool;
+    }
+
+    void ReadWithThreads(const std::vector<OpenedFile>& files, std::vector<ReadRequest>& requests, std::size_t queue_depth) {
+        std::atomic<std::size_t> next = 0;
+        ReadPool(queue_depth)->ForEachRange(std::min(queue_depth, requests.size()), [&](std::size_t, std::size_t, std::size_t) {
+            for (auto i = next++; i < requests.size(); i = next++) {
+                auto& request = requests[i];
+                const auto& file = files[request.file];
+                while (request.length > 0) {
+                    const auto read_bytes = pread(file.fd, request.iov.iov_base, request.iov.iov_len, request.offset);
+                    if (read_bytes == -1 && errno == EINTR) {
+                        continue;
+                    }
+                    if (read_bytes == -1) {
+                        throw std::runtime_error("Failed to read file: " + file.path + " " + strerror(errno));
+                    }
+                    Advance(request, file, read_bytes);
+                }
+            }
+        });
+    }
+
+    // Minimal single threaded io_uring on raw system calls, liburing is not
+    // required. Supports just what ReadWithUring needs.
+    class Uring {
+    public:
+        // Throws when io_uring is unsupported or disabled, e.g. by seccomp.
+        explicit Uring(unsigned entries) {
+            io_uring_params params;
+            std::memset(&params, 0, sizeof(params));
+            fd_ = syscall(__NR_io_uring_setup, entries, &params);
+            if (fd_ == -1) {
+                throw std::runtime_error(std::string("Failed to set up io_uring: ") + strerror(errno));
+            }
+            sq_entries_ = params.sq_entries;
+
+            sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            if (params.features & IORING_FEAT_SINGLE_MMAP) {
+                sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+            }
+            sq_ring_ = Map(sq_ring_size_, IORING_OFF_SQ_RING);
+            if (params.features & IORING_FEAT_SINGLE_MMAP) {
+                cq_ring_ = sq_ring_;
+            } else {
+                cq_ring_ = Map(cq_ring_size_, IORING_OFF_CQ_RING);
+            }
+            sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+            sqes_ = static_cast<io_uring_sqe*>(Map(sqes_size_, IORING_OFF_SQES));
+
+            const auto sq = static_cast<char*>(sq_ring_);
+            sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+            sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+            sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+            sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+            const auto cq = static_cast<char*>(cq_ring_);
+            cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+            cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+            cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+            cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        }
+
+        ~Uring() {
+            Release();
+        }
+
+        Uring(const Uring&) = delete;
+        Uring& operator=(const Uring&) = delete;
+
+        unsigned GetEntries() const {
+            return sq_entries_;
+        }
+
+        // False when the submission queue is full.
+        bool PrepareReadv(int fd, const iovec* iov, std::uint64_t offset, std::uint64_t user_data) {
+            const auto tail = *sq_tail_;
+            if (tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_) {
+                return false;
+            }
+            const auto index = tail & sq_mask_;
+            auto& sqe = sqes_[index];
+            std::memset(&sqe, 0, sizeof(sqe));
+            sqe.opcode = IORING_OP_READV;
+            sqe.fd = fd;
+            sqe.addr = reinterpret_cast<std::uint64_t>(iov);
+            sqe.len = 1;
+            sqe.off = offset;
+            sqe.user_data = user_data;
+            sq_array_[index] = index;
+            __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+            ++to_submit_;
+            return true;
+        }
+
+        // Submits prepared entries and waits for at least min_complete completions.
+        void Submit(unsigned min_complete) {
+            while (true) {
+                const auto submitted = syscall(__NR_io_uring_enter, fd_, to_submit_, min_complete, min_complete > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+                if (submitted == -1 && errno == EINTR) {
+                    continue;
+                }
+                if (submitted == -1) {
+                    throw std::runtime_error(std::string("Failed to submit io_uring requests: ") + strerror(errno));
+                }
+                to_submit_ -= submitted;
+                return;
+            }
+        }
+
+        // Calls f(user_data, result) for every available completion.
+        template <typename F>
+        void ForEachCompletion(F&& f) {
+            auto head = *cq_head_;
+            const auto tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+            for (; head != tail; ++head) {
+                const auto& cqe = cqes_[head & cq_mask_];
+                f(cqe.user_data, cqe.res);
+            }
+            __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+        }
+
+    private:
+        void* Map(std::size_t size, off_t offset) {
+            const auto ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, offset);
+            if (ptr == MAP_FAILED) {
+                const auto error = errno;
+                Release();
+                throw std::runtime_error(std::string("Failed to map io_uring: ") + strerror(error));
+            }
+            return ptr;
+        }
+
+        void Release() {
+            if (sqes_ != nullptr) {
+                munmap(sqes_, sqes_size_);
+            }
+            if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+                munmap(cq_ring_, cq_ring_size_);
+            }
+            if (sq_ring_ != nullptr) {
+                munmap(sq_ring_, sq_ring_size_);
+            }
+            close(fd_);
+        }
+
+        int fd_ = -1;
+        unsigned sq_entries_ = 0;
+        unsigned to_submit_ = 0;
+
+        void* sq_ring_ = nullptr;
+        std::size_t sq_ring_size_ = 0;
+        void* cq_ring_ = nullptr;
+        std::size_t cq_ring_size_ = 0;
+        io_uring_sqe* sqes_ = nullptr;
+        std::size_t sqes_size_ = 0;
+
+        unsigned* sq_head_ = nullptr;
+        unsigned* sq_tail_ = nullptr;
+        unsigned sq_mask_ = 0;
+        unsigned* sq_array_ = nullptr;
+        unsigned* cq_head_ = nullptr;
+        unsigned* cq_tail_ = nullptr;
+        unsigned cq_mask_ = 0;
+        io_uring_cqe* cqes_ = nullptr;
+    };
+
+    // Keeps up to queue_depth reads in flight. On error, reads already in
+    // flight are drained before throwing, the kernel writes into the buffers.
+    void ReadWithUring(Uring& ring, const std::vector<OpenedFile>& files, std::vector<ReadRequest>& requests, std::size_t queue_depth) {
+        std::vector<std::size_t> pending;
+        pending.reserve(requests.size());
+        for (auto i = requests.size(); i > 0; --i) {
+            pending.push_back(i - 1);
+        }
+
+        std::size_t in_flight = 0;
+        std::string error;
+        while (in_flight > 0 || (error.empty() && !pending.empty())) {
+            while (error.empty() && !pending.empty() && in_flight < queue_depth) {
+                const auto id = pending.back();
+                const auto& request = requests[id];
+                if (!ring.PrepareReadv(files[request.file].fd, &request.iov, request.offset, id)) {
+                    break;
+                }
+                pending.pop_back();
+                ++in_flight;
+            }
+
+            ring.Submit(1);
+            ring.ForEachCompletion([&](std::uint64_t id, int result) {
+                --in_flight;
+                auto& request = requests[id];
+                const auto& file = files[request.file];
+                if (result < 0) {
+                    if (error.empty()) {
+                        error = "Failed to read file: " + file.path + " " + strerror(-result);
+                    }
+                    return;
+                }
+                try {
+                    Advance(request, file, result);
+                } catch (const std::exception& e) {
+                    if (error.empty()) {
+                        error = e.what();
+                    }
+                    return;
+                }
+                if (request.length > 0) {
+                    pending.push_back(id);
+                }
+            });
+        }
+        if (!error.empty()) {
+            throw std::runtime_error(error);
+        }
+    }
+
+    // Set once io_uring setup fails, e.g. when disabled by seccomp.
+    std::atomic<bool> uring_unavailable = false;
+
+    // Rings are single threaded, each thread reading with io_uring keeps its
+    // own for later reads instead of setting up and mapping a new one.
+    std::unique_ptr<Uring>& ThreadRing() {
+        thread_local std::unique_ptr<Uring> ring;
+        return ring;
+    }
+
+    void ReadTargets(const std::vector<OpenedFile>& files, std::vector<ReadTarget>& targets, IoBackend backend, std::size_t queue_depth) {
+        queue_depth = std::max<std::size_t>(queue_depth, 1);
+        auto requests = SplitIntoRequests(files, targets);
+        if (requests.empty()) {
+            return;
+        }
+
+        if (backend == IoBackend::Uring && !uring_unavailable.load(std::memory_order_relaxed)) {
+            auto& ring = ThreadRing();
+            if (ring == nullptr || ring->GetEntries() < queue_depth) {
+                ring.reset();
+                try {
+                    ring = std::make_unique<Uring>(queue_depth);
+                } catch (const std::runtime_error&) {
+                    // Read with threads instead.
+                    uring_unavailable = true;
+                }
+            }
+            if (ring != nullptr) {
+                try {
+                    ReadWithUring(*ring, files, requests, queue_depth);
+                } catch (...) {
+                    // Queues of the ring may be left with entries of the failed read.
+                    ring.reset();
+                    throw;
+                }
+                return;
+            }
+        }
+        ReadWithThreads(files, requests, queue_depth);
+    }
+
+} // namespace
+
+IoBackend ParseIoBackend(const std::string& name) {
+    if (name == "mmap") {
+        return IoBackend::Mmap;
+    } else if (name == "uring") {
+        return IoBackend::Uring;
+    } else if (name == "threads") {
+        return IoBackend::Threads;
+    } else {
+        throw std::runtime_error("Unknown I/O backend, supported backends are [mmap, uring, threads]");
+    }
+}
+
+std::vector<std::shared_ptr<IStream>> ReadFiles(const std::vector<std::string>& paths, IoBackend backend, std::size_t queue_depth, bool direct) {
+    std::vector<std::shared_ptr<IStream>> streams;
+    streams.reserve(paths.size());
+    if (backend == IoBackend::Mmap) {
+        for (const auto& path : paths) {
+            streams.push_back(GetInputStream(path, direct));
+        }
+        return streams;
+    }
+
+    OpenedFiles opened;
+    opened.files.resize(paths.size());
+    std::vector<ReadTarget> targets;
+    for (std::size_t i = 0; i < paths.size(); ++i) {
+        Open(paths[i], direct, opened.files[i]);
+        targets.push_back(MakeTarget(opened.files, i, 0, opened.files[i].size));
+    }
+    ReadTargets(opened.files, targets, backend, queue_depth);
+
+    for (auto& target : targets) {
+        streams.push_back(std::make_shared<BufferReader>(std::move(target.buffer), target.size - target.skip, target.skip));
+    }
+    return streams;
+}
+
+std::vector<std::shared_ptr<IStream>> ReadFileRanges(const std::string& path, const std::vector<FileRange>& ranges, IoBackend backend, std::size_t queue_depth, bool direct) {
+    std::vector<std::shared_ptr<IStream>> streams;
+    streams.reserve(ranges.size());
+    if (backend == IoBackend::Mmap && direct) {
+        for (const auto& range : ranges) {
+            streams.push_back(std::make_shared<DirectFileReader>(path.c_str(), range.offset, range.length));
+        }
+        return streams;
+    }
+    if (backend == IoBackend::Mmap) {
+        const auto mapping = std::make_shared<MmapFileReader>(path.c_str());
+        for (const auto& range : ranges) {
+            streams.push_back(std::make_shared<SliceReader>(mapping, range.offset, range.length));
+        }
+        return streams;
+    }
+
+    OpenedFiles opened;
+    opened.files.resize(1);
+    Open(path, direct, opened.files[0]);
+    std::vector<ReadTarget> targets;
+    for (const auto& range : ranges) {
+        targets.push_back(MakeTarget(opened.files, 0, range.offset, range.length));
+    }
+    ReadTargets(opened.files, targets, backend, queue_depth);
+
+    for (auto& target : targets) {
+        streams.push_back(std::make_shared<BufferReader>(std::move(target.buffer), target.size - target.skip, target.skip));
+    }
+    return streams;
+}
+
+} // namespace lib::chunk_impl
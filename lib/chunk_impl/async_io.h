@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <lib/chunk_impl/io.h>
+
+namespace lib::chunk_impl {
+
+enum class IoBackend {
+    // Every file is mapped, pages are faulted in one at a time while decoding.
+    Mmap,
+    // Files are read up front with io_uring, falls back to Threads where the
+    // kernel does not allow it.
+    Uring,
+    // Files are read up front with pread(2) from a thread pool.
+    Threads,
+};
+
+// Accepts "mmap", "uring" and "threads".
+IoBackend ParseIoBackend(const std::string& name);
+
+// Opens streams over all paths at once. Except for Mmap, the files are read
+// into memory with up to queue_depth reads in flight across all of them, so
+// cold storage is read at its bandwidth rather than at the latency of one
+// request. With direct, files are read with O_DIRECT, and Mmap opens them as
+// streams (see DirectFileReader). Other returned streams support views. The
+// pread(2) thread pool and io_uring rings are reused between calls.
+std::vector<std::shared_ptr<IStream>> ReadFiles(const std::vector<std::string>& paths, IoBackend backend, std::size_t queue_depth, bool direct = false);
+
+struct FileRange {
+    std::size_t offset;
+    std::size_t length;
+};
+
+// Same for ranges of one file. Mmap maps the file once and slices it.
+std::vector<std::shared_ptr<IStream>> ReadFileRanges(const std::string& path, const std::vector<FileRange>& ranges, IoBackend backend, std::size_t queue_depth, bool direct = false);
+
+} // namespace lib::chunk_impl
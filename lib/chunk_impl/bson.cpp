@@ -9,7 +9,25 @@ namespace lib::chunk_impl {
 
 namespace {
 
-    void SkipValue(IStream& stream) {
+    // Decoders are templated on the input, IStream or SpanCursor over mmapped
+    // chunks, the latter reads straight from memory.
+
+    // Key bytes are only needed until the key is interned, so one buffer is
+    // reused when the input can not hand out views.
+    template <typename Input>
+    std::string_view ReadKey(Input& stream) {
+        const auto length = Read4Bytes(stream);
+        if (stream.SupportsViews()) {
+            return stream.ReadView(length);
+        }
+        thread_local std::string buffer;
+        buffer.resize(length);
+        stream.Read(buffer.data(), length);
+        return buffer;
+    }
+
+    template <typename Input>
+    void SkipValue(Input& stream) {
         auto cch = ReadControlChar(stream);
 
         switch (*cch) {
@@ -41,30 +59,31 @@ namespace {
         }
     }
 
-    std::optional<std::shared_ptr<document::Value>> ReadValue(IStream& stream, const TreeNodePtr& root) {
+    template <typename Input>
+    std::optional<std::shared_ptr<document::Value>> ReadValue(Input& stream, const TreeNodePtr& root, const document::ArenaPtr& arena, bool borrow_strings) {
         const auto cch = ReadControlChar(stream);
         if (!cch.has_value()) {
             return std::nullopt;
         }
 
         if (IsPrimitiveControlChar(*cch)) {
-            return ReadPrimitiveValue(*cch, stream);
+            return ReadPrimitiveValue(*cch, stream, arena, borrow_strings);
         }
 
+        auto resource = document::GetResource(arena);
+
         switch (*cch) {
             case ControlChar::kDocumentFlag: {
                 auto length = Read4Bytes(stream);
                 auto end = stream.Tellg();
                 end += length;
 
-                document::ValueMap doc_map;
+                document::ValueMap doc_map(resource);
                 while (stream.Tellg() < end) {
-                    auto key_length = Read4Bytes(stream);
-                    char buffer[key_length];
-                    stream.Read(buffer, key_length);
-                    auto key = std::string(buffer, key_length);
+                    const auto key_name = ReadKey(stream);
                     if (root->IsLeaf()) {
-                        auto maybe_v = ReadValue(stream, root);
+                        const auto key = document::InternKey(key_name);
+                        auto maybe_v = ReadValue(stream, root, arena, borrow_strings);
                         if (!maybe_v.has_value()) {
                             throw std::runtime_error("Unexpected end of file");
                         }
@@ -72,58 +91,99 @@ namespace {
                         continue;
                     }
 
-                    const auto it = root->children.find(key);
+                    // Keys outside the projection are never interned.
+                    const auto key = document::FindKey(key_name);
+                    const auto it = key ? root->children.find(*key) : root->children.end();
                     if (it == root->children.end()) {
                         SkipValue(stream);
                         continue;
                     }
 
-                    doc_map[key] = ReadValue(stream, it->second).value();
+                    doc_map[*key] = ReadValue(stream, it->second, arena, borrow_strings).value();
                 }
-                return std::static_pointer_cast<document::Value>(std::make_shared<document::Document>(std::move(doc_map)));
+                return std::static_pointer_cast<document::Value>(document::MakeValue<document::Document>(arena, std::move(doc_map)));
             }
             case ControlChar::kListFlag: {
                 auto length = Read4Bytes(stream);
                 auto end = stream.Tellg();
                 end += length;
 
-                document::ValueList list;
+                document::ValueList list(resource);
                 while (stream.Tellg() < end) {
-                    auto maybe_v = ReadValue(stream, root);
+                    auto maybe_v = ReadValue(stream, root, arena, borrow_strings);
                     if (!maybe_v.has_value()) {
                         throw std::runtime_error("Unexpected end of file");
                     }
                     list.push_back(maybe_v.value());
                 }
-                return std::static_pointer_cast<document::Value>(std::make_shared<document::List>(std::move(list)));
+                return std::static_pointer_cast<document::Value>(document::MakeValue<document::List>(arena, std::move(list)));
             }
             default:
                 throw std::logic_error("Unreachable code");
         }
     }
 
-} // namespace
+    template <typename Input>
+    std::optional<document::CompactValue> ReadCompactValue(Input& stream, const TreeNodePtr& root, document::CompactBuilder& builder, bool borrow_strings) {
+        const auto cch = ReadControlChar(stream);
+        if (!cch.has_value()) {
+            return std::nullopt;
+        }
 
-std::vector<std::shared_ptr<document::Document>> BsonChunk::Read(const TreeNodePtr& tree) const {
-    auto stream = GetInputStream(path);
+        if (IsPrimitiveControlChar(*cch)) {
+            return ReadPrimitiveCompactValue(*cch, stream, builder, borrow_strings);
+        }
 
-    std::vector<std::shared_ptr<document::Document>> result;
+        switch (*cch) {
+            case ControlChar::kDocumentFlag: {
+                auto length = Read4Bytes(stream);
+                auto end = stream.Tellg();
+                end += length;
 
-    while (true) {
-        auto doc = ReadValue(*stream, tree);
-        if (!doc.has_value()) {
-            break;
-        }
-        if (doc.value()->GetTypeId() != document::TypeId::kDocument) {
-            throw std::runtime_error("Awaited document type, got " + document::TypeIdToString(doc.value()->GetTypeId()));
-        }
-        result.emplace_back(std::static_pointer_cast<document::Document>(doc.value()));
-    }
+                const auto mark = builder.StartDocument();
+                while (stream.Tellg() < end) {
+                    const auto key_name = ReadKey(stream);
+                    if (root->IsLeaf()) {
+                        const auto key = document::InternKey(key_name);
+                        auto maybe_v = ReadCompactValue(stream, root, builder, borrow_strings);
+                        if (!maybe_v.has_value()) {
+                            throw std::runtime_error("Unexpected end of file");
+                        }
+                        builder.AddField(key, maybe_v.value());
+                        continue;
+                    }
 
-    return result;
-}
+                    // Keys outside the projection are never interned.
+                    const auto key = document::FindKey(key_name);
+                    const auto it = key ? root->children.find(*key) : root->children.end();
+                    if (it == root->children.end()) {
+                        SkipValue(stream);
+                        continue;
+                    }
 
-namespace {
+                    builder.AddField(*key, ReadCompactValue(stream, it->second, builder, borrow_strings).value());
+                }
+                return builder.FinishDocument(mark);
+            }
+            case ControlChar::kListFlag: {
+                auto length = Read4Bytes(stream);
+                auto end = stream.Tellg();
+                end += length;
+
+                const auto mark = builder.StartList();
+                while (stream.Tellg() < end) {
+                    auto maybe_v = ReadCompactValue(stream, root, builder, borrow_strings);
+                    if (!maybe_v.has_value()) {
+                        throw std::runtime_error("Unexpected end of file");
+                    }
+                    builder.AddItem(maybe_v.value());
+                }
+                return builder.FinishList(mark);
+            }
+            default:
+                throw std::logic_error("Unreachable code");
+        }
+    }
 
     std::vector<char> SerializeValue(const std::shared_ptr<document::Value>& value) {
         if (value->IsOfPrimitiveType()) {
@@ -139,7 +199,7 @@ namespace {
 
                 std::vector<char> serialized_document;
                 for (const auto& [k, v] : map) {
-                    auto serialized_key = SerializeString(k);
+                    auto serialized_key = SerializeString(document::KeyName(k));
                     serialized_document.insert(serialized_document.end(), std::make_move_iterator(serialized_key.begin()), std::make_move_iterator(serialized_key.end()));
                     auto serialized_value = SerializeValue(v);
                     serialized_document.insert(serialized_document.end(), std::make_move_iterator(serialized_value.begin()), std::make_move_iterator(serialized_value.end()));
@@ -170,17 +230,168 @@ namespace {
         }
     }
 
-} // namespace
+    std::vector<char> SerializeValue(const document::CompactValue& value) {
+        if (value.IsOfPrimitiveType()) {
+            return SerializePrimitiveValue(value);
+        }
 
-void BsonChunk::Write(const std::vector<std::shared_ptr<document::Document>>& documents) const {
-    auto stream = GetOutputStream(path);
+        std::vector<char> result;
+        std::vector<char> serialized_children;
 
-    for (const auto& document : documents) {
-        auto serialized = SerializeValue(std::static_pointer_cast<document::Value>(document));
-        stream->Write(&serialized[0], serialized.size());
+        switch (value.GetTypeId()) {
+            case document::TypeId::kDocument: {
+                result.emplace_back(static_cast<char>(ControlChar::kDocumentFlag));
+                for (auto it = value.FieldsBegin(); it != value.FieldsEnd(); ++it) {
+                    auto serialized_key = SerializeString(document::KeyName(it->key));
+                    serialized_children.insert(serialized_children.end(), serialized_key.begin(), serialized_key.end());
+                    auto serialized_value = SerializeValue(it->value);
+                    serialized_children.insert(serialized_children.end(), serialized_value.begin(), serialized_value.end());
+                }
+                break;
+            }
+            case document::TypeId::kList: {
+                result.emplace_back(static_cast<char>(ControlChar::kListFlag));
+                for (auto it = value.ItemsBegin(); it != value.ItemsEnd(); ++it) {
+                    auto serialized_value = SerializeValue(*it);
+                    serialized_children.insert(serialized_children.end(), serialized_value.begin(), serialized_value.end());
+                }
+                break;
+            }
+            default:
+                throw std::logic_error("Unreachable code");
+        }
+
+        auto serialized_size = Serialize4Bytes(serialized_children.size());
+        result.insert(result.end(), serialized_size.begin(), serialized_size.end());
+        result.insert(result.end(), serialized_children.begin(), serialized_children.end());
+        return result;
     }
 
-    stream->Flush();
+    class BsonReader: public ChunkReader {
+    public:
+        BsonReader(const std::string& path, const TreeNodePtr& tree, const ChunkOptions& options)
+            : ChunkReader(options)
+            , stream_(GetInputStream(path, options.direct_io))
+            , tree_(tree)
+            , borrow_strings_(options.zero_copy_strings && stream_->SupportsViews()) {
+            if (const auto memory_reader = std::dynamic_pointer_cast<MemoryReader>(stream_)) {
+                cursor_ = memory_reader->GetCursor();
+            }
+        }
+
+        std::vector<std::shared_ptr<document::Document>> NextBatch() override {
+            if (cursor_.has_value()) {
+                return ReadBatch(*cursor_);
+            }
+            return ReadBatch(*stream_);
+        }
+
+        document::CompactBatch NextCompactBatch() override {
+            if (cursor_.has_value()) {
+                return ReadCompactBatch(*cursor_);
+            }
+            return ReadCompactBatch(*stream_);
+        }
+
+    private:
+        template <typename Input>
+        std::vector<std::shared_ptr<document::Document>> ReadBatch(Input& input) {
+            auto arena = options.use_arena || borrow_strings_ ? std::make_shared<document::Arena>() : nullptr;
+            if (borrow_strings_) {
+                arena->Retain(stream_);
+            }
+
+            std::vector<std::shared_ptr<document::Document>> result;
+            while (result.size() < options.batch_size) {
+                auto doc = ReadValue(input, tree_, arena, borrow_strings_);
+                if (!doc.has_value()) {
+                    break;
+                }
+                if (doc.value()->GetTypeId() != document::TypeId::kDocument) {
+                    throw std::runtime_error("Awaited document type, got " + document::TypeIdToString(doc.value()->GetTypeId()));
+                }
+                result.emplace_back(std::static_pointer_cast<document::Document>(doc.value()));
+            }
+
+            return result;
+        }
+
+        template <typename Input>
+        document::CompactBatch ReadCompactBatch(Input& input) {
+            document::CompactBatch result;
+            result.arena = std::make_shared<document::Arena>();
+            document::CompactBuilder builder(result.arena);
+            if (borrow_strings_) {
+                result.arena->Retain(stream_);
+            }
+
+            while (result.documents.size() < options.batch_size) {
+                auto doc = ReadCompactValue(input, tree_, builder, borrow_strings_);
+                if (!doc.has_value()) {
+                    break;
+                }
+                if (doc->GetTypeId() != document::TypeId::kDocument) {
+                    throw std::runtime_error("Awaited document type, got " + document::TypeIdToString(doc->GetTypeId()));
+                }
+                result.documents.push_back(doc.value());
+            }
+
+            return result;
+        }
+
+        std::shared_ptr<IStream> stream_;
+        // Set for mmapped input, decoding goes through it instead of stream_.
+        std::optional<SpanCursor> cursor_;
+        TreeNodePtr tree_;
+        bool borrow_strings_;
+    };
+
+    class BsonWriter: public ChunkWriter {
+    public:
+        BsonWriter(const std::string& path, const ChunkOptions& options)
+            : ChunkWriter(options)
+            , stream_(GetOutputStream(path, options.size_hint, options.durability, options.direct_io)) {
+        }
+
+        void WriteBatch(const std::vector<std::shared_ptr<document::Document>>& documents) override {
+            for (const auto& document : documents) {
+                auto serialized = SerializeValue(std::static_pointer_cast<document::Value>(document));
+                stream_->Write(&serialized[0], serialized.size());
+            }
+        }
+
+        void WriteCompactBatch(const document::CompactBatch& batch) override {
+            for (const auto& document : batch.documents) {
+                auto serialized = SerializeValue(document);
+                stream_->Write(&serialized[0], serialized.size());
+            }
+        }
+
+        bool SupportsCompactBatches() const override {
+            return true;
+        }
+
+        void Finish() override {
+            stream_->Close(options.durability);
+            stream_.reset();
+        }
+
+    private:
+        std::shared_ptr<OStream> stream_;
+    };
+
+} // namespace
+
+std::unique_ptr<ChunkReader> BsonChunk::CreateReader(const TreeNodePtr& tree, const ChunkOptions& options) const {
+    return std::make_unique<BsonReader>(path, tree, options);
+}
+
+std::unique_ptr<ChunkWriter> BsonChunk::CreateWriter(const ChunkOptions& options) const {
+    return std::make_unique<BsonWriter>(path, options);
+}
+
+DocumentCursor BsonChunk::OpenCursor() const {
+    return DocumentCursor(GetInputStream(path));
 }
 
 } // namespace lib::chunk_impl
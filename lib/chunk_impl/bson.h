@@ -1,17 +1,22 @@
 #pragma once
 
+#include <lib/chunk_impl/bson_view.h>
 #include <lib/chunk_impl/chunk.h>
 
 namespace lib::chunk_impl {
 
 class BsonChunk: public Chunk {
 public:
-    BsonChunk(const std::string& path)
-        : Chunk(path) {
+    BsonChunk(const std::string& path, const ChunkOptions& options = {})
+        : Chunk(path, options) {
     }
 
-    std::vector<std::shared_ptr<document::Document>> Read(const TreeNodePtr& tree = TreeNode::Default()) const override;
-    void Write(const std::vector<std::shared_ptr<document::Document>>& documents) const override;
+    // Lazy access to stored documents without decoding them, see DocumentCursor.
+    DocumentCursor OpenCursor() const;
+
+protected:
+    std::unique_ptr<ChunkReader> CreateReader(const TreeNodePtr& tree, const ChunkOptions& options) const override;
+    std::unique_ptr<ChunkWriter> CreateWriter(const ChunkOptions& options) const override;
 };
 
 } // namespace lib::chunk_impl
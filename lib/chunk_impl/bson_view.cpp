@@ -0,0 +1,317 @@
+#include "bson_view.h"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace lib::chunk_impl {
+
+namespace {
+
+    constexpr std::size_t kLengthSize = 4;
+
+    const char* SkipFieldKey(const char* position) {
+        return position + kLengthSize + Load4Bytes(position);
+    }
+
+} // namespace
+
+ValueView::ValueView(const char* data)
+    : data_(data) {
+}
+
+ControlChar ValueView::GetControlChar() const {
+    return static_cast<ControlChar>(data_[0]);
+}
+
+const char* ValueView::GetPayload(ControlChar expected) const {
+    if (GetControlChar() != expected) {
+        throw std::runtime_error("Unexpected type " + document::TypeIdToString(GetTypeId()));
+    }
+    return data_ + 1;
+}
+
+document::TypeId ValueView::GetTypeId() const {
+    switch (GetControlChar()) {
+        case ControlChar::kNullFlag:
+            return document::TypeId::kNull;
+        case ControlChar::kBooleanFlag:
+            return document::TypeId::kBoolean;
+        case ControlChar::kInt32Flag:
+            return document::TypeId::kInt32;
+        case ControlChar::kUint32Flag:
+            return document::TypeId::kUint32;
+        case ControlChar::kInt64Flag:
+            return document::TypeId::kInt64;
+        case ControlChar::kUint64Flag:
+            return document::TypeId::kUint64;
+        case ControlChar::kFloat32Flag:
+            return document::TypeId::kFloat32;
+        case ControlChar::kFloat64Flag:
+            return document::TypeId::kFloat64;
+        case ControlChar::kStringFlag:
+            return document::TypeId::kString;
+        case ControlChar::kDocumentFlag:
+            return document::TypeId::kDocument;
+        case ControlChar::kListFlag:
+            return document::TypeId::kList;
+        default:
+            throw std::runtime_error("Unexpected control character");
+    }
+}
+
+bool ValueView::IsNull() const {
+    return GetControlChar() == ControlChar::kNullFlag;
+}
+
+bool ValueView::GetBoolean() const {
+    return static_cast<bool>(*GetPayload(ControlChar::kBooleanFlag));
+}
+
+int32_t ValueView::GetInt32() const {
+    return static_cast<int32_t>(Load4Bytes(GetPayload(ControlChar::kInt32Flag)));
+}
+
+uint32_t ValueView::GetUInt32() const {
+    return Load4Bytes(GetPayload(ControlChar::kUint32Flag));
+}
+
+int64_t ValueView::GetInt64() const {
+    return static_cast<int64_t>(Load8Bytes(GetPayload(ControlChar::kInt64Flag)));
+}
+
+uint64_t ValueView::GetUInt64() const {
+    return Load8Bytes(GetPayload(ControlChar::kUint64Flag));
+}
+
+float ValueView::GetFloat32() const {
+    const auto temp = Load4Bytes(GetPayload(ControlChar::kFloat32Flag));
+    float res;
+    std::memcpy(&res, &temp, sizeof(float));
+    return res;
+}
+
+double ValueView::GetFloat64() const {
+    const auto temp = Load8Bytes(GetPayload(ControlChar::kFloat64Flag));
+    double res;
+    std::memcpy(&res, &temp, sizeof(double));
+    return res;
+}
+
+std::string_view ValueView::GetString() const {
+    const auto payload = GetPayload(ControlChar::kStringFlag);
+    return std::string_view(payload + kLengthSize, Load4Bytes(payload));
+}
+
+DocumentView ValueView::GetDocument() const {
+    GetPayload(ControlChar::kDocumentFlag);
+    return DocumentView(data_);
+}
+
+ListView ValueView::GetList() const {
+    GetPayload(ControlChar::kListFlag);
+    return ListView(data_);
+}
+
+std::size_t ValueView::GetEncodedSize() const {
+    switch (GetControlChar()) {
+        case ControlChar::kNullFlag:
+            return 1;
+        case ControlChar::kBooleanFlag:
+            return 2;
+        case ControlChar::kInt32Flag:
+        case ControlChar::kUint32Flag:
+        case ControlChar::kFloat32Flag:
+            return 5;
+        case ControlChar::kInt64Flag:
+        case ControlChar::kUint64Flag:
+        case ControlChar::kFloat64Flag:
+            return 9;
+        case ControlChar::kStringFlag:
+        case ControlChar::kDocumentFlag:
+        case ControlChar::kListFlag:
+            return 1 + kLengthSize + Load4Bytes(data_ + 1);
+        default:
+            throw std::runtime_error("Unexpected control character");
+    }
+}
+
+std::shared_ptr<document::Value> ValueView::Materialize(const document::ArenaPtr& arena) const {
+    switch (GetControlChar()) {
+        case ControlChar::kNullFlag:
+            return std::static_pointer_cast<document::Value>(document::MakeValue<document::Null>(arena));
+        case ControlChar::kBooleanFlag:
+            return std::static_pointer_cast<document::Value>(document::MakeValue<document::Boolean>(arena, GetBoolean()));
+        case ControlChar::kInt32Flag:
+            return std::static_pointer_cast<document::Value>(document::MakeValue<document::Int32>(arena, GetInt32()));
+        case ControlChar::kUint32Flag:
+            return std::static_pointer_cast<document::Value>(document::MakeValue<document::UInt32>(arena, GetUInt32()));
+        case ControlChar::kInt64Flag:
+            return std::static_pointer_cast<document::Value>(document::MakeValue<document::Int64>(arena, GetInt64()));
+        case ControlChar::kUint64Flag:
+            return std::static_pointer_cast<document::Value>(document::MakeValue<document::UInt64>(arena, GetUInt64()));
+        case ControlChar::kFloat32Flag:
+            return std::static_pointer_cast<document::Value>(document::MakeValue<document::Float32>(arena, GetFloat32()));
+        case ControlChar::kFloat64Flag:
+            return std::static_pointer_cast<document::Value>(document::MakeValue<document::Float64>(arena, GetFloat64()));
+        case ControlChar::kStringFlag:
+            return std::static_pointer_cast<document::Value>(document::MakeValue<document::String>(arena, GetString(), document::GetResource(arena)));
+        case ControlChar::kDocumentFlag:
+            return std::static_pointer_cast<document::Value>(GetDocument().Materialize(arena));
+        case ControlChar::kListFlag:
+            return std::static_pointer_cast<document::Value>(GetList().Materialize(arena));
+        default:
+            throw std::runtime_error("Unexpected control character");
+    }
+}
+
+DocumentView::Iterator::Iterator(const char* position, const char* end)
+    : position_(position)
+    , end_(end) {
+}
+
+FieldView DocumentView::Iterator::operator*() const {
+    return FieldView{std::string_view(position_ + kLengthSize, Load4Bytes(position_)), ValueView(SkipFieldKey(position_))};
+}
+
+DocumentView::Iterator& DocumentView::Iterator::operator++() {
+    const auto value = SkipFieldKey(position_);
+    position_ = value + ValueView(value).GetEncodedSize();
+    if (position_ > end_) {
+        throw std::runtime_error("Malformed BSON document");
+    }
+    return *this;
+}
+
+bool DocumentView::Iterator::operator==(const Iterator& other) const {
+    return position_ == other.position_;
+}
+
+bool DocumentView::Iterator::operator!=(const Iterator& other) const {
+    return position_ != other.position_;
+}
+
+DocumentView::DocumentView(const char* data)
+    : data_(data)
+    , begin_(data + 1 + kLengthSize)
+    , end_(begin_ + Load4Bytes(data + 1)) {
+}
+
+DocumentView::Iterator DocumentView::begin() const {
+    return Iterator(begin_, end_);
+}
+
+DocumentView::Iterator DocumentView::end() const {
+    return Iterator(end_, end_);
+}
+
+std::optional<ValueView> DocumentView::Find(std::string_view key) const {
+    for (const auto& field : *this) {
+        if (field.key == key) {
+            return field.value;
+        }
+    }
+    return std::nullopt;
+}
+
+std::size_t DocumentView::GetEncodedSize() const {
+    return end_ - data_;
+}
+
+std::shared_ptr<document::Document> DocumentView::Materialize(const document::ArenaPtr& arena) const {
+    document::ValueMap doc_map(document::GetResource(arena));
+    for (const auto& field : *this) {
+        doc_map[document::InternKey(field.key)] = field.value.Materialize(arena);
+    }
+    return document::MakeValue<document::Document>(arena, std::move(doc_map));
+}
+
+ListView::Iterator::Iterator(const char* position, const char* end)
+    : position_(position)
+    , end_(end) {
+}
+
+ValueView ListView::Iterator::operator*() const {
+    return ValueView(position_);
+}
+
+ListView::Iterator& ListView::Iterator::operator++() {
+    position_ += ValueView(position_).GetEncodedSize();
+    if (position_ > end_) {
+        throw std::runtime_error("Malformed BSON list");
+    }
+    return *this;
+}
+
+bool ListView::Iterator::operator==(const Iterator& other) const {
+    return position_ == other.position_;
+}
+
+bool ListView::Iterator::operator!=(const Iterator& other) const {
+    return position_ != other.position_;
+}
+
+ListView::ListView(const char* data)
+    : data_(data)
+    , begin_(data + 1 + kLengthSize)
+    , end_(begin_ + Load4Bytes(data + 1)) {
+}
+
+ListView::Iterator ListView::begin() const {
+    return Iterator(begin_, end_);
+}
+
+ListView::Iterator ListView::end() const {
+    return Iterator(end_, end_);
+}
+
+std::optional<ValueView> ListView::At(std::size_t index) const {
+    for (const auto& item : *this) {
+        if (index == 0) {
+            return item;
+        }
+        --index;
+    }
+    return std::nullopt;
+}
+
+std::size_t ListView::Size() const {
+    std::size_t size = 0;
+    for (auto it = begin(); it != end(); ++it) {
+        ++size;
+    }
+    return size;
+}
+
+std::size_t ListView::GetEncodedSize() const {
+    return end_ - data_;
+}
+
+std::shared_ptr<document::List> ListView::Materialize(const document::ArenaPtr& arena) const {
+    document::ValueList list(document::GetResource(arena));
+    for (const auto& item : *this) {
+        list.push_back(item.Materialize(arena));
+    }
+    return document::MakeValue<document::List>(arena, std::move(list));
+}
+
+DocumentCursor::DocumentCursor(const std::shared_ptr<IStream>& stream)
+    : stream_(stream) {
+    if (!stream_->SupportsViews()) {
+        throw std::runtime_error("Lazy BSON views require memory mapped input");
+    }
+}
+
+std::optional<DocumentView> DocumentCursor::Next() {
+    if (stream_->Peek() == EOF) {
+        return std::nullopt;
+    }
+
+    const auto header = stream_->ReadView(1 + kLengthSize);
+    if (static_cast<ControlChar>(header[0]) != ControlChar::kDocumentFlag) {
+        throw std::runtime_error("Awaited document type, got " + document::TypeIdToString(ValueView(header.data()).GetTypeId()));
+    }
+    stream_->ReadView(Load4Bytes(header.data() + 1));
+    return DocumentView(header.data());
+}
+
+} // namespace lib::chunk_impl
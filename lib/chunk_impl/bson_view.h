@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+
+#include <lib/chunk_impl/common.h>
+#include <lib/chunk_impl/io.h>
+#include <lib/document/arena.h>
+#include <lib/document/document.h>
+
+namespace lib::chunk_impl {
+
+class DocumentView;
+class ListView;
+
+// Lazy view of a BSON-encoded value, data points to its control character.
+// Scalars are decoded on access, nested values are walked on demand using
+// their length prefixes. Views do not own memory and are valid while the
+// underlying bytes are.
+class ValueView {
+public:
+    explicit ValueView(const char* data);
+
+    document::TypeId GetTypeId() const;
+    bool IsNull() const;
+
+    bool GetBoolean() const;
+    int32_t GetInt32() const;
+    uint32_t GetUInt32() const;
+    int64_t GetInt64() const;
+    uint64_t GetUInt64() const;
+    float GetFloat32() const;
+    double GetFloat64() const;
+    std::string_view GetString() const;
+    DocumentView GetDocument() const;
+    ListView GetList() const;
+
+    // Size of encoding including control character.
+    std::size_t GetEncodedSize() const;
+    std::shared_ptr<document::Value> Materialize(const document::ArenaPtr& arena = nullptr) const;
+
+private:
+    ControlChar GetControlChar() const;
+    const char* GetPayload(ControlChar expected) const;
+
+    const char* data_;
+};
+
+struct FieldView {
+    std::string_view key;
+    ValueView value;
+};
+
+class DocumentView {
+public:
+    class Iterator {
+    public:
+        Iterator(const char* position, const char* end);
+
+        FieldView operator*() const;
+        Iterator& operator++();
+        bool operator==(const Iterator& other) const;
+        bool operator!=(const Iterator& other) const;
+
+    private:
+        const char* position_;
+        const char* end_;
+    };
+
+    explicit DocumentView(const char* data);
+
+    Iterator begin() const;
+    Iterator end() const;
+
+    // Walks fields in order, values of other keys are skipped without decoding.
+    std::optional<ValueView> Find(std::string_view key) const;
+    std::size_t GetEncodedSize() const;
+    std::shared_ptr<document::Document> Materialize(const document::ArenaPtr& arena = nullptr) const;
+
+private:
+    const char* data_;
+    const char* begin_;
+    const char* end_;
+};
+
+class ListView {
+public:
+    class Iterator {
+    public:
+        Iterator(const char* position, const char* end);
+
+        ValueView operator*() const;
+        Iterator& operator++();
+        bool operator==(const Iterator& other) const;
+        bool operator!=(const Iterator& other) const;
+
+    private:
+        const char* position_;
+        const char* end_;
+    };
+
+    explicit ListView(const char* data);
+
+    Iterator begin() const;
+    Iterator end() const;
+
+    // Linear in the number of preceding items.
+    std::optional<ValueView> At(std::size_t index) const;
+    std::size_t Size() const;
+    std::size_t GetEncodedSize() const;
+    std::shared_ptr<document::List> Materialize(const document::ArenaPtr& arena = nullptr) const;
+
+private:
+    const char* data_;
+    const char* begin_;
+    const char* end_;
+};
+
+// Iterates top-level documents of a BSON chunk without decoding them.
+// Requires input backed by memory (see IStream::SupportsViews), returned views
+// are valid while the cursor is alive.
+class DocumentCursor {
+public:
+    explicit DocumentCursor(const std::shared_ptr<IStream>& stream);
+
+    std::optional<DocumentView> Next();
+
+private:
+    std::shared_ptr<IStream> stream_;
+};
+
+} // namespace lib::chunk_impl
@@ -0,0 +1,51 @@
+#include "chunk.h"
+
+#include <limits>
+
+namespace lib::chunk_impl {
+
+document::CompactBatch ChunkReader::NextCompactBatch() {
+    return document::ToCompactBatch(NextBatch());
+}
+
+void ChunkWriter::WriteCompactBatch(const document::CompactBatch& batch) {
+    WriteBatch(document::FromCompactBatch(batch, options.use_arena ? std::make_shared<document::Arena>() : nullptr));
+}
+
+bool ChunkWriter::SupportsCompactBatches() const {
+    return false;
+}
+
+std::unique_ptr<ChunkReader> Chunk::OpenReader(const TreeNodePtr& tree) const {
+    return CreateReader(tree, options);
+}
+
+std::unique_ptr<ChunkWriter> Chunk::OpenWriter() const {
+    return CreateWriter(options);
+}
+
+std::vector<std::shared_ptr<document::Document>> Chunk::Read(const TreeNodePtr& tree) const {
+    auto whole_chunk = options;
+    whole_chunk.batch_size = std::numeric_limits<std::size_t>::max();
+    return CreateReader(tree, whole_chunk)->NextBatch();
+}
+
+void Chunk::Write(const std::vector<std::shared_ptr<document::Document>>& documents) const {
+    auto writer = OpenWriter();
+    writer->WriteBatch(documents);
+    writer->Finish();
+}
+
+document::CompactBatch Chunk::ReadCompact(const TreeNodePtr& tree) const {
+    auto whole_chunk = options;
+    whole_chunk.batch_size = std::numeric_limits<std::size_t>::max();
+    return CreateReader(tree, whole_chunk)->NextCompactBatch();
+}
+
+void Chunk::WriteCompact(const document::CompactBatch& batch) const {
+    auto writer = OpenWriter();
+    writer->WriteCompactBatch(batch);
+    writer->Finish();
+}
+
+} // namespace lib::chunk_impl
@@ -1,24 +1,118 @@
 #pragma once
 
 #include <unordered_set>
+#include <cstdint>
+#include <memory>
 #include <optional>
 #include <string>
 
+#include <lib/chunk_impl/async_io.h>
+#include <lib/chunk_impl/columnar_file.h>
+#include <lib/chunk_impl/io.h>
 #include <lib/chunk_impl/prefix_tree.h>
+#include <lib/document/compact_value.h>
 #include <lib/document/document.h>
 
 namespace lib::chunk_impl {
 
+struct ChunkOptions {
+    // Place documents of every batch into a single document::Arena instead of
+    // allocating each node and string on the heap.
+    bool use_arena = true;
+    // Strings of mmapped inputs reference the mapping instead of being copied.
+    // The mapping is retained by the arena of the returned documents, so this
+    // implies an arena. Has no effect on stdin.
+    bool zero_copy_strings = false;
+    // Maximum number of documents returned by ChunkReader::NextBatch.
+    std::size_t batch_size = 1024;
+    // Number of threads decoding a batch. Used by JSON chunks read from a file
+    // and single-file columnar chunks, which assemble row groups in parallel.
+    // Other readers decode on the calling thread.
+    std::size_t parse_threads = 1;
+    // Expected size of a written chunk in bytes, 0 when unknown. Output files
+    // are preallocated for it. Columnar chunks are spread over many files and
+    // ignore it.
+    std::size_t size_hint = 0;
+    // Applied to the chunk as a whole when the writer finishes.
+    Durability durability = Durability::Full;
+    // How columnar chunks read their leaf files, other chunks are mapped.
+    IoBackend io_backend = IoBackend::Mmap;
+    // Reads in flight at once, unless io_backend is Mmap.
+    std::size_t io_depth = 32;
+    // Chunk files bypass the page cache with O_DIRECT. Files are streamed
+    // instead of mapped, so zero-copy strings and parallel JSON parsing are
+    // unavailable.
+    bool direct_io = false;
+    // Layout of written columnar chunks, the layout of read ones is detected.
+    ColumnarLayout columnar_layout = ColumnarLayout::Directory;
+    // Floating-point columns are written byte stream split when Gorilla
+    // encoding does not shrink them, for chunks compressed afterwards.
+    bool split_float_bytes = false;
+    // Records per row group of columnar chunks in the single file layout.
+    // Columns of a group are held in memory until it is complete, 0 writes
+    // all records as one group.
+    std::size_t row_group_size = 1 << 16;
+};
+
+// Pull-based reader. Every batch owns its memory (arena, retained input), so
+// peak memory is bounded by batch size as long as consumed batches are dropped.
+class ChunkReader {
+public:
+    const ChunkOptions options;
+
+    explicit ChunkReader(const ChunkOptions& options)
+        : options(options) {
+    }
+    virtual ~ChunkReader() = default;
+
+    // Empty batch means the end of chunk.
+    virtual std::vector<std::shared_ptr<document::Document>> NextBatch() = 0;
+    // By default converted from NextBatch.
+    virtual document::CompactBatch NextCompactBatch();
+};
+
+// Push-based writer. Finish must be called after the last batch, it flushes
+// and closes underlying files.
+class ChunkWriter {
+public:
+    const ChunkOptions options;
+
+    explicit ChunkWriter(const ChunkOptions& options)
+        : options(options) {
+    }
+    virtual ~ChunkWriter() = default;
+
+    virtual void WriteBatch(const std::vector<std::shared_ptr<document::Document>>& documents) = 0;
+    // By default converted to regular documents.
+    virtual void WriteCompactBatch(const document::CompactBatch& batch);
+    // Whether WriteCompactBatch encodes compact values without conversion.
+    virtual bool SupportsCompactBatches() const;
+    virtual void Finish() = 0;
+};
+
 class Chunk {
 public:
     const std::string path;
+    const ChunkOptions options;
 
-    Chunk(const std::string path)
-        : path(path) {
+    Chunk(const std::string path, const ChunkOptions& options = {})
+        : path(path)
+        , options(options) {
     }
+    virtual ~Chunk() = default;
+
+    std::unique_ptr<ChunkReader> OpenReader(const TreeNodePtr& tree = TreeNode::Default()) const;
+    std::unique_ptr<ChunkWriter> OpenWriter() const;
+
+    // Whole chunk at once, in a single batch.
+    std::vector<std::shared_ptr<document::Document>> Read(const TreeNodePtr& tree = TreeNode::Default()) const;
+    void Write(const std::vector<std::shared_ptr<document::Document>>& documents) const;
+    document::CompactBatch ReadCompact(const TreeNodePtr& tree = TreeNode::Default()) const;
+    void WriteCompact(const document::CompactBatch& batch) const;
 
-    virtual std::vector<std::shared_ptr<document::Document>> Read(const TreeNodePtr& tree = TreeNode::Default()) const = 0;
-    virtual void Write(const std::vector<std::shared_ptr<document::Document>>& documents) const = 0;
+protected:
+    virtual std::unique_ptr<ChunkReader> CreateReader(const TreeNodePtr& tree, const ChunkOptions& options) const = 0;
+    virtual std::unique_ptr<ChunkWriter> CreateWriter(const ChunkOptions& options) const = 0;
 };
 
 } // namespace lib::chunk_impl
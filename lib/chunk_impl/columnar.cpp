@@ -1,6 +1,10 @@
 #include "columnar.h"
 
+#include <deque>
 #include <filesystem>
+#include <functional>
+#include <future>
+#include <unordered_map>
 
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
@@ -8,11 +12,40 @@
 #include <lib/chunk_impl/dremel/assembly.h>
 #include <lib/chunk_impl/dremel/field_reader.h>
 #include <lib/chunk_impl/dremel/field_writer.h>
+#include <lib/chunk_impl/columnar_file.h>
+#include <lib/chunk_impl/common.h>
 #include <lib/chunk_impl/io.h>
+#include <lib/chunk_impl/thread_pool.h>
 
 namespace lib::chunk_impl {
 
 namespace {
+    rapidjson::Document ParseSchema(const std::string& schema_json_str) {
+        rapidjson::Document schema;
+
+        if (schema.Parse(schema_json_str.c_str()).HasParseError()) {
+            throw std::runtime_error("Failed to parse schema JSON");
+        }
+
+        if (!schema.IsObject()) {
+            throw std::runtime_error("Schema JSON is not an object");
+        }
+
+        return schema;
+    }
+
+    std::string SerializeSchema(const rapidjson::Document& schema) {
+        rapidjson::StringBuffer buffer;
+        rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+        schema.Accept(writer);
+        return std::string(buffer.GetString(), buffer.GetSize());
+    }
+
+    bool IsSingleFile(const std::string& path) {
+        std::error_code ec;
+        return std::filesystem::is_regular_file(path, ec);
+    }
+
     void CreateDirectoryIfNeeded(const std::string& path) {
         std::filesystem::path chunk_path(path);
 
@@ -43,7 +76,8 @@ namespace {
                 root_writer->AddChild(child);
                 RecurseCreateWritersTree(value->GetObject(), child);
             } else {
-                auto child = std::make_shared<dremel::FieldWriter>(root_writer->GetChunkPath(), root_writer, field_name, field_label, dremel::FieldType::Primitive, max_repetition_level, definition_level);
+                const auto physical_type = value->IsString() ? dremel::ParsePhysicalType(value->GetString()) : dremel::PhysicalType::Tagged;
+                auto child = std::make_shared<dremel::FieldWriter>(root_writer->GetChunkPath(), root_writer, field_name, field_label, dremel::FieldType::Primitive, max_repetition_level, definition_level, physical_type);
                 root_writer->AddChild(child);
             }
         }
@@ -54,7 +88,8 @@ namespace {
             auto max_repetition_level = root_reader->GetMaxRepetitionLevel();
             auto definition_level = root_reader->GetDefinitionLevel() + 1;
             const auto field_name = std::string(kv.name.GetString());
-            if (!tree->IsLeaf() && tree->children.find(field_name) == tree->children.end()) {
+            const auto field_key = document::InternKey(field_name);
+            if (!tree->IsLeaf() && tree->children.find(field_key) == tree->children.end()) {
                 continue;
             }
 
@@ -70,80 +105,389 @@ namespace {
             if (value->IsObject()) {
                 auto child = std::make_shared<dremel::FieldReader>(root_reader->GetChunkPath(), root_reader, field_name, field_label, dremel::FieldType::Object, max_repetition_level, definition_level);
                 root_reader->AddChild(child);
-                RecurseCreateReadersTree(value->GetObject(), child, tree->IsLeaf() ? tree : tree->children[field_name]);
+                RecurseCreateReadersTree(value->GetObject(), child, tree->IsLeaf() ? tree : tree->children[field_key]);
             } else {
-                auto child = std::make_shared<dremel::FieldReader>(root_reader->GetChunkPath(), root_reader, field_name, field_label, dremel::FieldType::Primitive, max_repetition_level, definition_level);
+                const auto physical_type = value->IsString() ? dremel::ParsePhysicalType(value->GetString()) : dremel::PhysicalType::Tagged;
+                auto child = std::make_shared<dremel::FieldReader>(root_reader->GetChunkPath(), root_reader, field_name, field_label, dremel::FieldType::Primitive, max_repetition_level, definition_level, physical_type);
                 root_reader->AddChild(child);
             }
         }
     }
-} // namespace
 
-rapidjson::Document ColumnarChunk::ReadSchema() const {
-    if (schema_path.empty()) {
-        throw std::runtime_error("Need to pass schema path for this operation");
+    using ReaderTreeFactory = std::function<std::shared_ptr<dremel::FieldReader>()>;
+
+    std::vector<std::shared_ptr<dremel::FieldReader>> GetLeafReaders(const std::shared_ptr<dremel::FieldReader>& root) {
+        std::vector<std::shared_ptr<dremel::FieldReader>> leaves;
+        for (const auto& leaf : dremel::LeafNodes(root)) {
+            leaves.push_back(std::static_pointer_cast<dremel::FieldReader>(leaf));
+        }
+        return leaves;
     }
 
-    auto istream = lib::chunk_impl::GetInputStream(schema_path);
-    std::string schema_json_str = istream->ReadLine();
+    // Ranges of the chunk file holding columns of leaves in row_group.
+    std::vector<FileRange> GetColumnRanges(const RowGroupMeta& row_group, const std::vector<std::shared_ptr<dremel::FieldReader>>& leaves) {
+        std::unordered_map<std::string, const ColumnMeta*> columns;
+        for (const auto& column : row_group.columns) {
+            columns.emplace(column.path, &column);
+        }
+        std::vector<FileRange> ranges;
+        for (const auto& leaf : leaves) {
+            const auto it = columns.find(leaf->ConstructPath());
+            if (it == columns.end()) {
+                throw std::runtime_error("Column is missing in columnar file: " + leaf->ConstructPath());
+            }
+            ranges.push_back({it->second->offset, it->second->length});
+        }
+        return ranges;
+    }
+
+    class ColumnarReader: public ChunkReader {
+    public:
+        ColumnarReader(const ReaderTreeFactory& create_tree, const std::optional<ColumnarFooter>& footer, const ChunkOptions& options)
+            : ChunkReader(options) {
+            const auto root = create_tree();
+            if (!root->HasAnyChild()) {
+                return;
+            }
+            if (!footer.has_value()) {
+                if (options.io_backend != IoBackend::Mmap || options.direct_io) {
+                    OpenLeafFiles(root);
+                }
+                reader_ = std::make_unique<dremel::RecordReader>(root, nullptr, options.zero_copy_strings);
+                return;
+            }
+            if (footer->row_groups.empty()) {
+                return;
+            }
 
-    rapidjson::Document schema;
+            path_ = *root->GetChunkPath();
+            row_groups_ = footer->row_groups;
+            if (options.parse_threads > 1 && row_groups_.size() > 1) {
+                // Every group is assembled by a worker with its own readers.
+                create_tree_ = create_tree;
+                pool_ = std::make_unique<ThreadPool>(options.parse_threads);
+                while (assembling_.size() < pool_->GetThreadsCount() && SubmitRowGroup()) {
+                }
+                return;
+            }
 
-    if (schema.Parse(schema_json_str.c_str()).HasParseError()) {
-        throw std::runtime_error("Failed to parse schema JSON");
-    }
+            leaves_ = GetLeafReaders(root);
+            if (row_groups_.size() > 1) {
+                pool_ = std::make_unique<ThreadPool>(1);
+            }
+            PrefetchRowGroup();
+            NextRowGroup();
+            reader_ = std::make_unique<dremel::RecordReader>(root, nullptr, options.zero_copy_strings);
+        }
+
+        std::vector<std::shared_ptr<document::Document>> NextBatch() override {
+            if (create_tree_ != nullptr) {
+                return NextBatchParallel();
+            }
+
+            std::vector<std::shared_ptr<document::Document>> res;
+            if (reader_ == nullptr) {
+                return res;
+            }
+
+            const auto arena = options.use_arena || options.zero_copy_strings ? std::make_shared<document::Arena>() : nullptr;
+            reader_->SetArena(arena);
+            while (res.size() < options.batch_size) {
+                auto doc = reader_->NextRecord();
+                if (doc == nullptr) {
+                    if (!NextRowGroup()) {
+                        break;
+                    }
+                    // Retains the new group's columns.
+                    reader_->SetArena(arena);
+                    continue;
+                }
+                res.emplace_back(std::move(doc));
+            }
+            return res;
+        }
+
+    private:
+        // Reads all projected columns at once instead of faulting them in while
+        // records are assembled, or opens them for direct streaming.
+        void OpenLeafFiles(const std::shared_ptr<dremel::FieldReader>& root) {
+            const auto leaves = GetLeafReaders(root);
+            std::vector<std::string> paths;
+            for (const auto& leaf : leaves) {
+                paths.push_back(leaf->GetFilePath());
+            }
+            auto streams = ReadFiles(paths, options.io_backend, options.io_depth, options.direct_io);
+            for (std::size_t i = 0; i < leaves.size(); ++i) {
+                leaves[i]->SetStream(streams[i]);
+            }
+        }
 
-    if (!schema.IsObject()) {
-        throw std::runtime_error("Schema JSON is not an object");
+        // Same for the single file layout, projected columns of a row group
+        // are ranges of the chunk file. Groups are read on a background thread
+        // one ahead of the group being assembled.
+        void PrefetchRowGroup() {
+            if (next_row_group_ >= row_groups_.size()) {
+                return;
+            }
+            auto task = std::make_shared<std::packaged_task<std::vector<std::shared_ptr<IStream>>()>>(
+                [path = path_, ranges = GetColumnRanges(row_groups_[next_row_group_], leaves_), options = options]() {
+                    return ReadFileRanges(path, ranges, options.io_backend, options.io_depth, options.direct_io);
+                });
+            next_streams_ = task->get_future();
+            if (pool_ != nullptr) {
+                pool_->Submit([task]() {
+                    (*task)();
+                });
+            } else {
+                (*task)();
+            }
+        }
+
+        // Switches leaves to the next row group, false after the last one.
+        bool NextRowGroup() {
+            if (next_row_group_ >= row_groups_.size()) {
+                return false;
+            }
+            auto streams = next_streams_.get();
+            for (std::size_t i = 0; i < leaves_.size(); ++i) {
+                leaves_[i]->SetStream(streams[i]);
+            }
+            ++next_row_group_;
+            PrefetchRowGroup();
+            return true;
+        }
+
+        // Queues assembly of all records of the next row group, false after
+        // the last one. Readers are created here, workers share nothing.
+        bool SubmitRowGroup() {
+            if (next_row_group_ >= row_groups_.size()) {
+                return false;
+            }
+            auto root = create_tree_();
+            auto task = std::make_shared<std::packaged_task<std::vector<std::shared_ptr<document::Document>>()>>(
+                [root, path = path_, ranges = GetColumnRanges(row_groups_[next_row_group_], GetLeafReaders(root)), options = options]() {
+                    const auto leaves = GetLeafReaders(root);
+                    auto streams = ReadFileRanges(path, ranges, options.io_backend, options.io_depth, options.direct_io);
+                    for (std::size_t i = 0; i < leaves.size(); ++i) {
+                        leaves[i]->SetStream(streams[i]);
+                    }
+                    const auto arena = options.use_arena || options.zero_copy_strings ? std::make_shared<document::Arena>() : nullptr;
+                    dremel::RecordReader reader(root, arena, options.zero_copy_strings);
+                    std::vector<std::shared_ptr<document::Document>> documents;
+                    while (auto doc = reader.NextRecord()) {
+                        documents.emplace_back(std::move(doc));
+                    }
+                    return documents;
+                });
+            assembling_.push_back(task->get_future());
+            pool_->Submit([task]() {
+                (*task)();
+            });
+            ++next_row_group_;
+            return true;
+        }
+
+        // Returns records of groups in order, batches span groups as in
+        // sequential reads.
+        std::vector<std::shared_ptr<document::Document>> NextBatchParallel() {
+            std::vector<std::shared_ptr<document::Document>> res;
+            while (res.size() < options.batch_size) {
+                if (assembled_position_ == assembled_.size()) {
+                    if (assembling_.empty()) {
+                        break;
+                    }
+                    assembled_ = assembling_.front().get();
+                    assembled_position_ = 0;
+                    assembling_.pop_front();
+                    SubmitRowGroup();
+                    continue;
+                }
+                const auto count = std::min(options.batch_size - res.size(), assembled_.size() - assembled_position_);
+                const auto begin = assembled_.begin() + assembled_position_;
+                res.insert(res.end(), std::make_move_iterator(begin), std::make_move_iterator(begin + count));
+                assembled_position_ += count;
+            }
+            return res;
+        }
+
+        std::unique_ptr<dremel::RecordReader> reader_;
+        std::string path_;
+        std::vector<RowGroupMeta> row_groups_;
+        std::size_t next_row_group_ = 0;
+        // Sequential reads of row groups.
+        std::vector<std::shared_ptr<dremel::FieldReader>> leaves_;
+        std::future<std::vector<std::shared_ptr<IStream>>> next_streams_;
+        // Parallel assembly, set with more than one parse thread.
+        ReaderTreeFactory create_tree_;
+        std::deque<std::future<std::vector<std::shared_ptr<document::Document>>>> assembling_;
+        std::vector<std::shared_ptr<document::Document>> assembled_;
+        std::size_t assembled_position_ = 0;
+        // Joined first, pending tasks own what they use.
+        std::unique_ptr<ThreadPool> pool_;
+    };
+
+    class ColumnarWriter: public ChunkWriter {
+    public:
+        ColumnarWriter(const std::shared_ptr<dremel::FieldWriter>& root, std::string schema, const ChunkOptions& options)
+            : ChunkWriter(options)
+            , schema_(std::move(schema)) {
+            if (options.columnar_layout == ColumnarLayout::File) {
+                // Columns of a row group are assembled in memory and written
+                // one after another when the group is complete.
+                root_ = root;
+                for (const auto& leaf : dremel::LeafNodes(root)) {
+                    const auto writer = std::static_pointer_cast<dremel::FieldWriter>(leaf);
+                    columns_.emplace_back(writer, std::make_shared<MemoryWriter>());
+                    writer->SetStream(columns_.back().second);
+                }
+                stream_ = GetOutputStream(*root->GetChunkPath(), options.size_hint, options.durability, options.direct_io);
+                stream_->Write(kColumnarFileMagic.data(), kColumnarFileMagic.size());
+                offset_ = kColumnarFileMagic.size();
+            } else if (root->HasAnyChild()) {
+                root_ = root;
+                if (options.direct_io) {
+                    for (const auto& leaf : dremel::LeafNodes(root)) {
+                        const auto writer = std::static_pointer_cast<dremel::FieldWriter>(leaf);
+                        writer->SetStream(GetOutputStream(writer->GetFilePath(), 0, Durability::None, true));
+                    }
+                }
+            }
+            if (root_ != nullptr && options.split_float_bytes) {
+                for (const auto& leaf : dremel::LeafNodes(root_)) {
+                    std::static_pointer_cast<dremel::FieldWriter>(leaf)->SetSplitFloatBytes(true);
+                }
+            }
+        }
+
+        void WriteBatch(const std::vector<std::shared_ptr<document::Document>>& documents) override {
+            if (root_ == nullptr) {
+                return;
+            }
+            for (const auto& doc : documents) {
+                root_->Write(doc);
+                ++row_group_records_;
+                if (stream_ != nullptr && options.row_group_size != 0 && row_group_records_ >= options.row_group_size) {
+                    WriteRowGroup();
+                }
+            }
+            records_count_ += documents.size();
+        }
+
+        // Leaf files are synced together: writeback of all of them is started
+        // before any is closed and waited for.
+        void Finish() override {
+            if (root_ == nullptr) {
+                return;
+            }
+            if (options.columnar_layout == ColumnarLayout::File) {
+                WriteSingleFile();
+                return;
+            }
+            if (options.durability == Durability::Full) {
+                root_->FlushAll(Durability::Async);
+            }
+            root_->CloseAll(options.durability);
+            if (options.durability == Durability::Full) {
+                SyncDirectory(*root_->GetChunkPath());
+            }
+            root_.reset();
+        }
+
+    private:
+        void WriteRowGroup() {
+            root_->FlushAll(Durability::None);
+            RowGroupMeta row_group;
+            row_group.records_count = row_group_records_;
+            for (auto& [writer, column] : columns_) {
+                const auto data = column->GetData();
+                stream_->Write(data.data(), data.size());
+                row_group.columns.push_back({writer->ConstructPath(), offset_, data.size(), writer->GetValuesCount()});
+                offset_ += data.size();
+                column = std::make_shared<MemoryWriter>();
+                writer->SetStream(column);
+            }
+            row_groups_.push_back(std::move(row_group));
+            row_group_records_ = 0;
+        }
+
+        void WriteSingleFile() {
+            if (row_group_records_ > 0) {
+                WriteRowGroup();
+            }
+            columns_.clear();
+            root_.reset();
+
+            ColumnarFooter footer;
+            footer.schema = std::move(schema_);
+            footer.records_count = records_count_;
+            footer.row_groups = std::move(row_groups_);
+            const auto serialized_footer = SerializeColumnarFooter(footer);
+            stream_->Write(serialized_footer.data(), serialized_footer.size());
+            const auto footer_size = Serialize4Bytes(serialized_footer.size());
+            stream_->Write(footer_size.data(), footer_size.size());
+            stream_->Write(kColumnarFileMagic.data(), kColumnarFileMagic.size());
+            stream_->Close(options.durability);
+            stream_.reset();
+        }
+
+        std::shared_ptr<dremel::FieldWriter> root_;
+        std::string schema_;
+        std::uint64_t records_count_ = 0;
+        // Single file layout, columns of the current row group.
+        std::vector<std::pair<std::shared_ptr<dremel::FieldWriter>, std::shared_ptr<MemoryWriter>>> columns_;
+        std::shared_ptr<OStream> stream_;
+        std::uint64_t offset_ = 0;
+        std::uint64_t row_group_records_ = 0;
+        std::vector<RowGroupMeta> row_groups_;
+    };
+} // namespace
+
+rapidjson::Document ColumnarChunk::ReadSchema() const {
+    if (schema_path.empty()) {
+        if (IsSingleFile(path)) {
+            return ParseSchema(ReadColumnarFooter(path).schema);
+        }
+        throw std::runtime_error("Need to pass schema path for this operation");
     }
 
-    return schema;
+    auto istream = lib::chunk_impl::GetInputStream(schema_path);
+    return ParseSchema(istream->ReadLine());
 }
 
-ColumnarChunk::ColumnarChunk(const std::string& chunk_path, const std::string& schema_path)
-    : Chunk(chunk_path)
+ColumnarChunk::ColumnarChunk(const std::string& chunk_path, const std::string& schema_path, const ChunkOptions& options)
+    : Chunk(chunk_path, options)
     , schema_path(schema_path) {
 }
 
-std::vector<std::shared_ptr<document::Document>> ColumnarChunk::Read(const TreeNodePtr& tree) const {
-    const auto schema = ReadSchema();
+std::unique_ptr<ChunkReader> ColumnarChunk::CreateReader(const TreeNodePtr& tree, const ChunkOptions& options) const {
+    // Columns of a single file are described by its own schema.
+    std::optional<ColumnarFooter> footer;
+    if (IsSingleFile(path)) {
+        footer = ReadColumnarFooter(path);
+    }
+    const auto schema = std::make_shared<rapidjson::Document>(footer.has_value() ? ParseSchema(footer->schema) : ReadSchema());
 
     const auto path_ptr = std::make_shared<std::string>(path);
-    auto root_field_reader = std::make_shared<dremel::FieldReader>(path_ptr, nullptr, "__root__", dremel::FieldLabel::Optional, dremel::FieldType::Object, 0, 0);
-    RecurseCreateReadersTree(schema, root_field_reader, tree);
-    if (!root_field_reader->HasAnyChild()) {
-        return {};
-    }
+    const auto create_tree = [schema, path_ptr, tree]() {
+        auto root_field_reader = std::make_shared<dremel::FieldReader>(path_ptr, nullptr, "__root__", dremel::FieldLabel::Optional, dremel::FieldType::Object, 0, 0);
+        RecurseCreateReadersTree(*schema, root_field_reader, tree);
+        return root_field_reader;
+    };
 
-    dremel::RecordReader reader(root_field_reader);
-    std::vector<std::shared_ptr<document::Document>> res;
-    while (true) {
-        auto doc = reader.NextRecord();
-        if (doc == nullptr) {
-            break;
-        }
-        res.emplace_back(std::move(doc));
-    }
-    return res;
+    return std::make_unique<ColumnarReader>(create_tree, footer, options);
 }
 
-void ColumnarChunk::Write(const std::vector<std::shared_ptr<document::Document>>& documents) const {
+std::unique_ptr<ChunkWriter> ColumnarChunk::CreateWriter(const ChunkOptions& options) const {
     const auto schema = ReadSchema();
 
-    CreateDirectoryIfNeeded(path);
+    if (options.columnar_layout == ColumnarLayout::Directory) {
+        CreateDirectoryIfNeeded(path);
+    }
     const auto path_ptr = std::make_shared<std::string>(path);
     auto root_field_writer = std::make_shared<dremel::FieldWriter>(path_ptr, nullptr, "__root__", dremel::FieldLabel::Optional, dremel::FieldType::Object, 0, 0);
     RecurseCreateWritersTree(schema, root_field_writer);
-    if (!root_field_writer->HasAnyChild()) {
-        return;
-    }
-
-    // std::cerr << root_field_writer->Dump() << '\n';
-    for (const auto& doc : documents) {
-        root_field_writer->Write(doc);
-    }
 
-    root_field_writer->FlushAll();
+    return std::make_unique<ColumnarWriter>(root_field_writer, options.columnar_layout == ColumnarLayout::File ? SerializeSchema(schema) : std::string(), options);
 }
 
 } // namespace lib::chunk_impl
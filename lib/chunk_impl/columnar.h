@@ -13,11 +13,13 @@ private:
     std::string schema_path;
 
 public:
-    ColumnarChunk(const std::string& chunk_path, const std::string& schema_path);
+    ColumnarChunk(const std::string& chunk_path, const std::string& schema_path, const ChunkOptions& options = {});
 
-    std::vector<std::shared_ptr<document::Document>> Read(const TreeNodePtr& tree = TreeNode::Default()) const override;
-    void Write(const std::vector<std::shared_ptr<document::Document>>& documents) const override;
     rapidjson::Document ReadSchema() const;
+
+protected:
+    std::unique_ptr<ChunkReader> CreateReader(const TreeNodePtr& tree, const ChunkOptions& options) const override;
+    std::unique_ptr<ChunkWriter> CreateWriter(const ChunkOptions& options) const override;
 };
 
 } // namespace lib::chunk_impl
@@ -0,0 +1,138 @@
+#include "columnar_file.h"
+
+#include <sys/stat.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <unistd.h>
+
+#include <lib/chunk_impl/common.h>
+
+namespace lib::chunk_impl {
+
+namespace {
+
+    constexpr std::size_t kTrailerSize = 4 + kColumnarFileMagic.size();
+
+    void Append(std::string& out, const std::vector<char>& bytes) {
+        out.append(bytes.data(), bytes.size());
+    }
+
+    void AppendColumns(std::string& out, const std::vector<ColumnMeta>& columns) {
+        Append(out, Serialize4Bytes(columns.size()));
+        for (const auto& column : columns) {
+            Append(out, SerializeString(column.path));
+            Append(out, Serialize8Bytes(column.offset));
+            Append(out, Serialize8Bytes(column.length));
+            Append(out, Serialize8Bytes(column.values_count));
+        }
+    }
+
+    std::vector<ColumnMeta> ReadColumns(SpanCursor& cursor) {
+        std::vector<ColumnMeta> columns(Read4Bytes(cursor));
+        for (auto& column : columns) {
+            column.path = ReadString(cursor);
+            column.offset = Read8Bytes(cursor);
+            column.length = Read8Bytes(cursor);
+            column.values_count = Read8Bytes(cursor);
+        }
+        return columns;
+    }
+
+    void ReadAt(int fd, char* buffer, std::size_t length, std::size_t offset, const std::string& path) {
+        while (length > 0) {
+            const auto read_bytes = pread(fd, buffer, length, offset);
+            if (read_bytes == -1 && errno == EINTR) {
+                continue;
+            }
+            if (read_bytes == -1) {
+                throw std::runtime_error("Failed to read file: " + path + " " + strerror(errno));
+            }
+            if (read_bytes == 0) {
+                throw std::runtime_error("Unexpected end of file: " + path);
+            }
+            buffer += read_bytes;
+            length -= read_bytes;
+            offset += read_bytes;
+        }
+    }
+
+} // namespace
+
+ColumnarLayout ParseColumnarLayout(const std::string& name) {
+    if (name == "directory") {
+        return ColumnarLayout::Directory;
+    } else if (name == "file") {
+        return ColumnarLayout::File;
+    } else {
+        throw std::runtime_error("Unknown columnar layout, supported layouts are [directory, file]");
+    }
+}
+
+std::string SerializeColumnarFooter(const ColumnarFooter& footer) {
+    std::string out;
+    out.push_back(static_cast<char>(kColumnarFooterVersion));
+    Append(out, SerializeString(footer.schema));
+    Append(out, Serialize8Bytes(footer.records_count));
+    Append(out, Serialize4Bytes(footer.row_groups.size()));
+    for (const auto& row_group : footer.row_groups) {
+        Append(out, Serialize8Bytes(row_group.records_count));
+        AppendColumns(out, row_group.columns);
+    }
+    return out;
+}
+
+ColumnarFooter ReadColumnarFooter(const std::string& path) {
+    const auto fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        throw std::runtime_error("Failed to open input file: " + path + " " + strerror(errno));
+    }
+    std::string data;
+    try {
+        struct stat st;
+        if (fstat(fd, &st) == -1) {
+            throw std::runtime_error("Failed to determine file size: " + path + " " + strerror(errno));
+        }
+        const std::size_t file_size = st.st_size;
+        if (file_size < kColumnarFileMagic.size() + kTrailerSize) {
+            throw std::runtime_error("Not a columnar file: " + path);
+        }
+
+        char trailer[kTrailerSize];
+        ReadAt(fd, trailer, kTrailerSize, file_size - kTrailerSize, path);
+        const std::size_t footer_size = Load4Bytes(trailer);
+        if (std::string_view(trailer + 4, kColumnarFileMagic.size()) != kColumnarFileMagic || footer_size > file_size - kTrailerSize - kColumnarFileMagic.size()) {
+            throw std::runtime_error("Not a columnar file: " + path);
+        }
+        data.resize(footer_size);
+        ReadAt(fd, data.data(), footer_size, file_size - kTrailerSize - footer_size, path);
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+    close(fd);
+
+    SpanCursor cursor(data.data(), data.data() + data.size());
+    char version;
+    cursor.Get(version);
+    if (version < 1 || static_cast<std::uint8_t>(version) > kColumnarFooterVersion) {
+        throw std::runtime_error("Unsupported columnar file version: " + path);
+    }
+
+    ColumnarFooter footer;
+    footer.schema = ReadString(cursor);
+    footer.records_count = Read8Bytes(cursor);
+    if (version == 1) {
+        footer.row_groups.push_back({footer.records_count, ReadColumns(cursor)});
+        return footer;
+    }
+    footer.row_groups.resize(Read4Bytes(cursor));
+    for (auto& row_group : footer.row_groups) {
+        row_group.records_count = Read8Bytes(cursor);
+        row_group.columns = ReadColumns(cursor);
+    }
+    return footer;
+}
+
+} // namespace lib::chunk_impl
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace lib::chunk_impl {
+
+enum class ColumnarLayout {
+    // A file per leaf field in the chunk directory.
+    Directory,
+    // All leaves in one file, located through its footer.
+    File,
+};
+
+// Accepts "directory" and "file".
+ColumnarLayout ParseColumnarLayout(const std::string& name);
+
+// Single file layout of a columnar chunk:
+//   magic | row groups | footer | footer size (4 bytes) | magic
+// A row group holds the columns of consecutive records, each column is a
+// complete leaf column of the group's records. Columns follow each other in
+// the order of schema leaves. The footer keeps the schema, so the chunk is
+// read without a separate schema file, and locates every column of every
+// group. Files of version 1 have a single row group.
+constexpr std::string_view kColumnarFileMagic = "VKRC";
+constexpr std::uint8_t kColumnarFooterVersion = 2;
+
+struct ColumnMeta {
+    // Leaf path, see dremel::FieldDescriptor::ConstructPath.
+    std::string path;
+    std::uint64_t offset = 0;
+    std::uint64_t length = 0;
+    // One per value or null written to the leaf.
+    std::uint64_t values_count = 0;
+};
+
+struct RowGroupMeta {
+    std::uint64_t records_count = 0;
+    std::vector<ColumnMeta> columns;
+};
+
+struct ColumnarFooter {
+    std::string schema;
+    std::uint64_t records_count = 0;
+    std::vector<RowGroupMeta> row_groups;
+};
+
+std::string SerializeColumnarFooter(const ColumnarFooter& footer);
+// Reads the footer with two reads from the end of file, throws if the file is
+// not in the single file layout.
+ColumnarFooter ReadColumnarFooter(const std::string& path);
+
+} // namespace lib::chunk_impl
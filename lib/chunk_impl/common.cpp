@@ -6,13 +6,102 @@
 
 namespace lib::chunk_impl {
 
+namespace {
+
+    template <typename Input>
+    std::shared_ptr<document::Value> ReadPrimitiveValueFrom(ControlChar cch, Input& stream, const document::ArenaPtr& arena, bool borrow_strings) {
+        switch (cch) {
+            case ControlChar::kNullFlag:
+                return std::static_pointer_cast<document::Value>(document::MakeValue<document::Null>(arena));
+            case ControlChar::kBooleanFlag: {
+                char ch;
+                stream.Get(ch);
+                return std::static_pointer_cast<document::Value>(document::MakeValue<document::Boolean>(arena, static_cast<bool>(ch)));
+            }
+            case ControlChar::kInt32Flag: {
+                auto val = static_cast<int32_t>(Read4Bytes(stream));
+                return std::static_pointer_cast<document::Value>(document::MakeValue<document::Int32>(arena, val));
+            }
+            case ControlChar::kUint32Flag: {
+                auto val = Read4Bytes(stream);
+                return std::static_pointer_cast<document::Value>(document::MakeValue<document::UInt32>(arena, val));
+            }
+            case ControlChar::kInt64Flag: {
+                auto val = static_cast<int64_t>(Read8Bytes(stream));
+                return std::static_pointer_cast<document::Value>(document::MakeValue<document::Int64>(arena, val));
+            }
+            case ControlChar::kUint64Flag: {
+                auto val = Read8Bytes(stream);
+                return std::static_pointer_cast<document::Value>(document::MakeValue<document::UInt64>(arena, val));
+            }
+            case ControlChar::kFloat32Flag: {
+                auto val = ReadFloat(stream);
+                return std::static_pointer_cast<document::Value>(document::MakeValue<document::Float32>(arena, val));
+            }
+            case ControlChar::kFloat64Flag: {
+                auto val = ReadDouble(stream);
+                return std::static_pointer_cast<document::Value>(document::MakeValue<document::Float64>(arena, val));
+            }
+            case ControlChar::kStringFlag: {
+                if (borrow_strings) {
+                    return std::static_pointer_cast<document::Value>(document::MakeValue<document::String>(arena, ReadStringView(stream), document::kBorrowed));
+                }
+                if (stream.SupportsViews()) {
+                    return std::static_pointer_cast<document::Value>(document::MakeValue<document::String>(arena, ReadStringView(stream), document::GetResource(arena)));
+                }
+                const auto length = Read4Bytes(stream);
+                std::pmr::string val(length, '\0', document::GetResource(arena));
+                stream.Read(val.data(), length);
+                return std::static_pointer_cast<document::Value>(document::MakeValue<document::String>(arena, std::move(val)));
+            }
+            default:
+                throw std::runtime_error("Not primitive value");
+        }
+    }
+
+    template <typename Input>
+    document::CompactValue ReadPrimitiveCompactValueFrom(ControlChar cch, Input& stream, document::CompactBuilder& builder, bool borrow_strings) {
+        switch (cch) {
+            case ControlChar::kNullFlag:
+                return document::CompactValue::Null();
+            case ControlChar::kBooleanFlag: {
+                char ch;
+                stream.Get(ch);
+                return document::CompactValue::Boolean(static_cast<bool>(ch));
+            }
+            case ControlChar::kInt32Flag:
+                return document::CompactValue::Int32(static_cast<int32_t>(Read4Bytes(stream)));
+            case ControlChar::kUint32Flag:
+                return document::CompactValue::UInt32(Read4Bytes(stream));
+            case ControlChar::kInt64Flag:
+                return document::CompactValue::Int64(static_cast<int64_t>(Read8Bytes(stream)));
+            case ControlChar::kUint64Flag:
+                return document::CompactValue::UInt64(Read8Bytes(stream));
+            case ControlChar::kFloat32Flag:
+                return document::CompactValue::Float32(ReadFloat(stream));
+            case ControlChar::kFloat64Flag:
+                return document::CompactValue::Float64(ReadDouble(stream));
+            case ControlChar::kStringFlag:
+                if (borrow_strings) {
+                    return builder.MakeBorrowedString(ReadStringView(stream));
+                }
+                if (stream.SupportsViews()) {
+                    return builder.MakeString(ReadStringView(stream));
+                }
+                return builder.MakeString(ReadString(stream));
+            default:
+                throw std::runtime_error("Not primitive value");
+        }
+    }
+
+} // namespace
+
 std::optional<ControlChar> ReadControlChar(IStream& stream) {
-    char ch = stream.Peek();
-    if (ch == EOF) {
+    if (stream.Eof()) {
         return std::nullopt;
     }
-    stream.Seekg(1);
-
+    char ch;
+    stream.Get(ch);
     return static_cast<ControlChar>(ch);
 }
 
@@ -33,46 +122,12 @@ bool IsPrimitiveControlChar(ControlChar cch) {
     }
 }
 
-std::shared_ptr<document::Value> ReadPrimitiveValue(ControlChar cch, IStream& stream) {
-    switch (cch) {
-        case ControlChar::kNullFlag:
-            return std::static_pointer_cast<document::Value>(std::make_shared<document::Null>());
-        case ControlChar::kBooleanFlag: {
-            char ch;
-            stream.Get(ch);
-            return std::static_pointer_cast<document::Value>(std::make_shared<document::Boolean>(static_cast<bool>(ch)));
-        }
-        case ControlChar::kInt32Flag: {
-            auto val = static_cast<int32_t>(Read4Bytes(stream));
-            return std::static_pointer_cast<document::Value>(std::make_shared<document::Int32>(val));
-        }
-        case ControlChar::kUint32Flag: {
-            auto val = Read4Bytes(stream);
-            return std::static_pointer_cast<document::Value>(std::make_shared<document::UInt32>(val));
-        }
-        case ControlChar::kInt64Flag: {
-            auto val = static_cast<int64_t>(Read8Bytes(stream));
-            return std::static_pointer_cast<document::Value>(std::make_shared<document::Int64>(val));
-        }
-        case ControlChar::kUint64Flag: {
-            auto val = Read8Bytes(stream);
-            return std::static_pointer_cast<document::Value>(std::make_shared<document::UInt64>(val));
-        }
-        case ControlChar::kFloat32Flag: {
-            auto val = ReadFloat(stream);
-            return std::static_pointer_cast<document::Value>(std::make_shared<document::Float32>(val));
-        }
-        case ControlChar::kFloat64Flag: {
-            auto val = Read8Bytes(stream);
-            return std::static_pointer_cast<document::Value>(std::make_shared<document::Float64>(val));
-        }
-        case ControlChar::kStringFlag: {
-            auto val = ReadString(stream);
-            return std::static_pointer_cast<document::Value>(std::make_shared<document::String>(std::move(val)));
-        }
-        default:
-            throw std::runtime_error("Not primitive value");
-    }
+std::shared_ptr<document::Value> ReadPrimitiveValue(ControlChar cch, IStream& stream, const document::ArenaPtr& arena, bool borrow_strings) {
+    return ReadPrimitiveValueFrom(cch, stream, arena, borrow_strings);
+}
+
+std::shared_ptr<document::Value> ReadPrimitiveValue(ControlChar cch, SpanCursor& cursor, const document::ArenaPtr& arena, bool borrow_strings) {
+    return ReadPrimitiveValueFrom(cch, cursor, arena, borrow_strings);
 }
 
 std::vector<char> SerializePrimitiveValue(const std::shared_ptr<document::Value>& value) {
@@ -133,45 +188,78 @@ std::vector<char> SerializePrimitiveValue(const std::shared_ptr<document::Value>
     }
 }
 
-uint64_t Read8Bytes(IStream& stream) {
-    std::uint64_t result = 0;
-    char buffer[8];
-    stream.Read(buffer, 8);
+document::CompactValue ReadPrimitiveCompactValue(ControlChar cch, IStream& stream, document::CompactBuilder& builder, bool borrow_strings) {
+    return ReadPrimitiveCompactValueFrom(cch, stream, builder, borrow_strings);
+}
 
-    result = static_cast<uint64_t>(static_cast<uint8_t>(buffer[0])) |
-             (static_cast<uint64_t>(static_cast<uint8_t>(buffer[1])) << 8) |
-             (static_cast<uint64_t>(static_cast<uint8_t>(buffer[2])) << 16) |
-             (static_cast<uint64_t>(static_cast<uint8_t>(buffer[3])) << 24) |
-             (static_cast<uint64_t>(static_cast<uint8_t>(buffer[4])) << 32) |
-             (static_cast<uint64_t>(static_cast<uint8_t>(buffer[5])) << 40) |
-             (static_cast<uint64_t>(static_cast<uint8_t>(buffer[6])) << 48) |
-             (static_cast<uint64_t>(static_cast<uint8_t>(buffer[7])) << 56);
+document::CompactValue ReadPrimitiveCompactValue(ControlChar cch, SpanCursor& cursor, document::CompactBuilder& builder, bool borrow_strings) {
+    return ReadPrimitiveCompactValueFrom(cch, cursor, builder, borrow_strings);
+}
+
+std::vector<char> SerializePrimitiveValue(const document::CompactValue& value) {
+    std::vector<char> result;
+    std::vector<char> serialized;
 
+    switch (value.GetTypeId()) {
+        case document::TypeId::kNull:
+            result.emplace_back((char)ControlChar::kNullFlag);
+            return result;
+        case document::TypeId::kBoolean:
+            result.emplace_back((char)ControlChar::kBooleanFlag);
+            result.emplace_back(static_cast<char>(value.GetBoolean()));
+            return result;
+        case document::TypeId::kInt32:
+            result.emplace_back((char)ControlChar::kInt32Flag);
+            serialized = Serialize4Bytes(static_cast<uint32_t>(value.GetInt32()));
+            break;
+        case document::TypeId::kUint32:
+            result.emplace_back((char)ControlChar::kUint32Flag);
+            serialized = Serialize4Bytes(value.GetUInt32());
+            break;
+        case document::TypeId::kInt64:
+            result.emplace_back((char)ControlChar::kInt64Flag);
+            serialized = Serialize8Bytes(static_cast<uint64_t>(value.GetInt64()));
+            break;
+        case document::TypeId::kUint64:
+            result.emplace_back((char)ControlChar::kUint64Flag);
+            serialized = Serialize8Bytes(value.GetUInt64());
+            break;
+        case document::TypeId::kFloat32:
+            result.emplace_back((char)ControlChar::kFloat32Flag);
+            serialized = SerializeFloat(value.GetFloat32());
+            break;
+        case document::TypeId::kFloat64:
+            result.emplace_back((char)ControlChar::kFloat64Flag);
+            serialized = SerializeDouble(value.GetFloat64());
+            break;
+        case document::TypeId::kString:
+            result.emplace_back((char)ControlChar::kStringFlag);
+            serialized = SerializeString(value.GetString());
+            break;
+        default:
+            throw std::runtime_error("Not primitive value");
+    }
+
+    result.insert(result.end(), serialized.begin(), serialized.end());
     return result;
 }
 
+uint64_t Read8Bytes(IStream& stream) {
+    char buffer[8];
+    stream.Read(buffer, 8);
+    return Load8Bytes(buffer);
+}
+
 uint16_t Read2Bytes(IStream& stream) {
-    std::uint16_t result = 0;
     char buffer[2];
     stream.Read(buffer, 2);
-
-    result = static_cast<uint8_t>(buffer[0]) |
-             (static_cast<uint8_t>(buffer[1]) << 8);
-
-    return result;
+    return Load2Bytes(buffer);
 }
 
 uint32_t Read4Bytes(IStream& stream) {
-    std::uint32_t result = 0;
     char buffer[4];
     stream.Read(buffer, 4);
-
-    result = static_cast<uint8_t>(buffer[0]) |
-             (static_cast<uint8_t>(buffer[1]) << 8) |
-             (static_cast<uint8_t>(buffer[2]) << 16) |
-             (static_cast<uint8_t>(buffer[3]) << 24);
-
-    return result;
+    return Load4Bytes(buffer);
 }
 
 float ReadFloat(IStream& stream) {
@@ -190,9 +278,14 @@ double ReadDouble(IStream& stream) {
 
 std::string ReadString(IStream& stream) {
     auto length = Read4Bytes(stream);
-    char buffer[length];
-    stream.Read(buffer, length);
-    return std::string(buffer, length);
+    std::string result(length, '\0');
+    stream.Read(result.data(), length);
+    return result;
+}
+
+std::string_view ReadStringView(IStream& stream) {
+    auto length = Read4Bytes(stream);
+    return stream.ReadView(length);
 }
 
 std::vector<char> Serialize2Bytes(uint16_t value) {
@@ -236,7 +329,7 @@ std::vector<char> SerializeDouble(double value) {
     return Serialize8Bytes(temp);
 }
 
-std::vector<char> SerializeString(const std::string& value) {
+std::vector<char> SerializeString(std::string_view value) {
     std::vector<char> result;
     auto serialized_length = Serialize4Bytes(value.size());
     result.insert(result.end(), std::make_move_iterator(serialized_length.begin()), std::make_move_iterator(serialized_length.end()));
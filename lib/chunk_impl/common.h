@@ -1,9 +1,12 @@
 #pragma once
 
+#include <cstring>
 #include <fstream>
 #include <optional>
 
 #include <lib/chunk_impl/io.h>
+#include <lib/document/arena.h>
+#include <lib/document/compact_value.h>
 #include <lib/document/document.h>
 
 namespace lib::chunk_impl {
@@ -22,10 +25,36 @@ enum class ControlChar {
     kListFlag = 'l',     // length vary
 };
 
+// Decoding functions have overloads for SpanCursor, which read directly from
+// memory without virtual calls.
 std::optional<ControlChar> ReadControlChar(IStream& stream);
 bool IsPrimitiveControlChar(ControlChar cch);
-std::shared_ptr<document::Value> ReadPrimitiveValue(ControlChar cch, IStream& stream);
+// With borrow_strings set, strings reference stream memory (see IStream::ReadView),
+// the caller is responsible for keeping the stream alive.
+std::shared_ptr<document::Value> ReadPrimitiveValue(ControlChar cch, IStream& stream, const document::ArenaPtr& arena = nullptr, bool borrow_strings = false);
+std::shared_ptr<document::Value> ReadPrimitiveValue(ControlChar cch, SpanCursor& cursor, const document::ArenaPtr& arena = nullptr, bool borrow_strings = false);
 std::vector<char> SerializePrimitiveValue(const std::shared_ptr<document::Value>& value);
+document::CompactValue ReadPrimitiveCompactValue(ControlChar cch, IStream& stream, document::CompactBuilder& builder, bool borrow_strings = false);
+document::CompactValue ReadPrimitiveCompactValue(ControlChar cch, SpanCursor& cursor, document::CompactBuilder& builder, bool borrow_strings = false);
+std::vector<char> SerializePrimitiveValue(const document::CompactValue& value);
+
+// Little-endian decoding of raw bytes.
+inline uint16_t Load2Bytes(const char* buffer) {
+    return static_cast<uint8_t>(buffer[0]) |
+           (static_cast<uint8_t>(buffer[1]) << 8);
+}
+
+inline uint32_t Load4Bytes(const char* buffer) {
+    return static_cast<uint32_t>(static_cast<uint8_t>(buffer[0])) |
+           (static_cast<uint32_t>(static_cast<uint8_t>(buffer[1])) << 8) |
+           (static_cast<uint32_t>(static_cast<uint8_t>(buffer[2])) << 16) |
+           (static_cast<uint32_t>(static_cast<uint8_t>(buffer[3])) << 24);
+}
+
+inline uint64_t Load8Bytes(const char* buffer) {
+    return static_cast<uint64_t>(Load4Bytes(buffer)) |
+           (static_cast<uint64_t>(Load4Bytes(buffer + 4)) << 32);
+}
 
 uint16_t Read2Bytes(IStream& stream);
 uint32_t Read4Bytes(IStream& stream);
@@ -33,12 +62,56 @@ uint64_t Read8Bytes(IStream& stream);
 float ReadFloat(IStream& stream);
 double ReadDouble(IStream& stream);
 std::string ReadString(IStream& stream);
+std::string_view ReadStringView(IStream& stream);
+
+inline std::optional<ControlChar> ReadControlChar(SpanCursor& cursor) {
+    if (cursor.Eof()) {
+        return std::nullopt;
+    }
+    char ch;
+    cursor.Get(ch);
+    return static_cast<ControlChar>(ch);
+}
+
+inline uint16_t Read2Bytes(SpanCursor& cursor) {
+    return Load2Bytes(cursor.ReadView(2).data());
+}
+
+inline uint32_t Read4Bytes(SpanCursor& cursor) {
+    return Load4Bytes(cursor.ReadView(4).data());
+}
+
+inline uint64_t Read8Bytes(SpanCursor& cursor) {
+    return Load8Bytes(cursor.ReadView(8).data());
+}
+
+inline float ReadFloat(SpanCursor& cursor) {
+    const auto temp = Read4Bytes(cursor);
+    float res;
+    std::memcpy(&res, &temp, sizeof(float));
+    return res;
+}
+
+inline double ReadDouble(SpanCursor& cursor) {
+    const auto temp = Read8Bytes(cursor);
+    double res;
+    std::memcpy(&res, &temp, sizeof(double));
+    return res;
+}
+
+inline std::string ReadString(SpanCursor& cursor) {
+    return std::string(cursor.ReadView(Read4Bytes(cursor)));
+}
+
+inline std::string_view ReadStringView(SpanCursor& cursor) {
+    return cursor.ReadView(Read4Bytes(cursor));
+}
 
 std::vector<char> Serialize2Bytes(uint16_t value);
 std::vector<char> Serialize4Bytes(uint32_t value);
 std::vector<char> Serialize8Bytes(uint64_t value);
 std::vector<char> SerializeFloat(float value);
 std::vector<char> SerializeDouble(double value);
-std::vector<char> SerializeString(const std::string& value);
+std::vector<char> SerializeString(std::string_view value);
 
 } // namespace lib::chunk_impl
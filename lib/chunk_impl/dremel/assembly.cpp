@@ -35,10 +35,11 @@ RepetitionLevel ReaderCache::LowestCommonMaxRepetitionLevel(const FieldReaderPtr
     return common_ancestor->GetMaxRepetitionLevel();
 }
 
-RecordReader::RecordReader(const FieldReaderPtr& root)
-    : root_(root)
+RecordReader::RecordReader(const FieldReaderPtr& root, const document::ArenaPtr& arena, bool borrow_strings)
+    : borrow_strings_(borrow_strings)
+    , root_(root)
     , cache_(std::make_shared<ReaderCache>())
-    , assembler_(RecordAssembler(cache_, root)) {
+    , assembler_(RecordAssembler(cache_, root, arena, borrow_strings)) {
     auto leaf_nodes = LeafNodes(root);
     leaf_nodes_.resize(leaf_nodes.size());
     std::transform(
@@ -51,6 +52,7 @@ RecordReader::RecordReader(const FieldReaderPtr& root)
         leaf_nodes_[i]->SetFieldIndex(i);
     }
     ConstructFSM();
+    SetArena(arena);
 
     // for (auto& fn : leaf_nodes_) {
     //     std::cerr << "fn " << fn->ToString() << '\n';
@@ -64,6 +66,15 @@ RecordReader::RecordReader(const FieldReaderPtr& root)
     // }
 }
 
+void RecordReader::SetArena(const document::ArenaPtr& arena) {
+    if (arena != nullptr && borrow_strings_) {
+        for (const auto& leaf : leaf_nodes_) {
+            arena->Retain(leaf->GetOrCreateStream());
+        }
+    }
+    assembler_.SetArena(arena);
+}
+
 void RecordReader::ConstructFSM() {
     for (auto i = 0; i < leaf_nodes_.size(); ++i) {
         const auto& current = leaf_nodes_[i];
@@ -97,19 +108,26 @@ void RecordReader::ConstructFSM() {
     }
 }
 
-RecordAssembler::RecordAssembler(const std::shared_ptr<ReaderCache>& cache, const FieldReaderPtr& root_node)
+RecordAssembler::RecordAssembler(const std::shared_ptr<ReaderCache>& cache, const FieldReaderPtr& root_node, const document::ArenaPtr& arena, bool borrow_strings)
     : cache_(cache)
-    , root_node_(root_node) {
+    , root_node_(root_node)
+    , arena_(arena)
+    , borrow_strings_(borrow_strings) {
+}
+
+void RecordAssembler::SetArena(const document::ArenaPtr& arena) {
+    arena_ = arena;
 }
 
 void RecordAssembler::Start() {
     stack_ = std::stack<AssemblerStackEntry>();
-    stack_.push({std::make_shared<document::Document>(), root_node_});
+    stack_.push({document::MakeValue<document::Document>(arena_, document::GetResource(arena_)), root_node_});
     last_node_ = nullptr;
 }
 
 void RecordAssembler::AssignValue(const FieldReaderPtr& reader) {
-    auto row = reader->ReadRow();
+    auto row = reader->ReadRow(arena_, borrow_strings_);
+    auto resource = document::GetResource(arena_);
     auto barrier = cache_->LowestCommonAncestor(reader, stack_.top().second);
 
     if (last_node_ != nullptr && reader->GetFieldIndex() <= last_node_->GetFieldIndex()) {
@@ -132,6 +150,8 @@ void RecordAssembler::AssignValue(const FieldReaderPtr& reader) {
         auto node = path.front();
         path.pop();
 
+        const auto key = node->GetFieldKey();
+
         if (node->IsLeaf()) {
             if (node != reader) {
                 throw std::logic_error("Unexpected leaf node " + node->ToString() + " before current " + reader->ToString());
@@ -141,22 +161,22 @@ void RecordAssembler::AssignValue(const FieldReaderPtr& reader) {
             }
 
             if (node->GetFieldLabel() == FieldLabel::Repeated) {
-                if (last->value.find(node->GetFieldName()) == last->value.end()) {
-                    last->value[node->GetFieldName()] = std::make_shared<document::List>();
+                if (last->value.find(key) == last->value.end()) {
+                    last->value[key] = document::MakeValue<document::List>(arena_, resource);
                 }
-                std::static_pointer_cast<document::List>(last->value[node->GetFieldName()])->value.push_back(row.value);
+                std::static_pointer_cast<document::List>(last->value[key])->value.push_back(row.value);
             } else {
-                last->value[node->GetFieldName()] = row.value;
+                last->value[key] = row.value;
             }
         } else if (!row.value->IsNull()) {
-            auto inner = std::make_shared<document::Document>();
+            auto inner = document::MakeValue<document::Document>(arena_, resource);
             if (node->GetFieldLabel() == FieldLabel::Repeated) {
-                if (last->value.find(node->GetFieldName()) == last->value.end()) {
-                    last->value[node->GetFieldName()] = std::make_shared<document::List>();
+                if (last->value.find(key) == last->value.end()) {
+                    last->value[key] = document::MakeValue<document::List>(arena_, resource);
                 }
-                std::static_pointer_cast<document::List>(last->value[node->GetFieldName()])->value.push_back(inner);
+                std::static_pointer_cast<document::List>(last->value[key])->value.push_back(inner);
             } else {
-                last->value[node->GetFieldName()] = inner;
+                last->value[key] = inner;
             }
             stack_.push({inner, node});
         }
@@ -3,6 +3,7 @@
 #include <stack>
 
 #include <lib/chunk_impl/dremel/field_reader.h>
+#include <lib/document/arena.h>
 #include <lib/document/document.h>
 
 namespace lib::chunk_impl::dremel {
@@ -30,10 +31,13 @@ private:
     FieldReaderPtr root_node_;
     FieldReaderPtr last_node_;
     std::stack<AssemblerStackEntry> stack_;
+    document::ArenaPtr arena_;
+    bool borrow_strings_;
 
 public:
-    RecordAssembler(const std::shared_ptr<ReaderCache>& cache, const FieldReaderPtr& root_node_);
+    RecordAssembler(const std::shared_ptr<ReaderCache>& cache, const FieldReaderPtr& root_node_, const document::ArenaPtr& arena = nullptr, bool borrow_strings = false);
 
+    void SetArena(const document::ArenaPtr& arena);
     void Start();
     void AssignValue(const FieldReaderPtr& reader);
 
@@ -46,14 +50,19 @@ private:
     FSM fsm_;
     std::shared_ptr<ReaderCache> cache_;
     std::vector<FieldReaderPtr> leaf_nodes_;
+    bool borrow_strings_;
     FieldReaderPtr root_;
     RecordAssembler assembler_;
 
     void ConstructFSM();
 
 public:
-    explicit RecordReader(const FieldReaderPtr& root);
+    // borrow_strings requires arena, see FieldReader::ReadRow.
+    explicit RecordReader(const FieldReaderPtr& root, const document::ArenaPtr& arena = nullptr, bool borrow_strings = false);
 
+    // Records read afterwards are allocated in arena. With borrow_strings the
+    // arena also retains mappings of all leaf files.
+    void SetArena(const document::ArenaPtr& arena);
     std::shared_ptr<document::Document> NextRecord();
 };
 
@@ -0,0 +1,563 @@
+#include "encoding.h"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+#include <lib/chunk_impl/common.h>
+
+namespace lib::chunk_impl::dremel {
+
+namespace {
+
+    constexpr std::size_t kGroupSize = 8;
+    // Shorter runs are cheaper bit-packed.
+    constexpr std::size_t kMinRunLength = 8;
+
+    std::size_t RunLength(const std::uint32_t* values, std::size_t count, std::size_t start) {
+        auto end = start + 1;
+        while (end < count && values[end] == values[start]) {
+            ++end;
+        }
+        return end - start;
+    }
+
+    void PutRun(std::string& out, std::uint32_t value, std::size_t length, unsigned bit_width) {
+        PutVarint(out, length << 1);
+        for (unsigned i = 0; i < (bit_width + 7) / 8; ++i) {
+            out.push_back(static_cast<char>(value >> (8 * i)));
+        }
+    }
+
+    void PutBitPacked(std::string& out, const std::uint32_t* values, std::size_t count, unsigned bit_width) {
+        const auto groups = (count + kGroupSize - 1) / kGroupSize;
+        PutVarint(out, (groups << 1) | 1);
+        std::uint64_t buffer = 0;
+        unsigned bits = 0;
+        for (std::size_t i = 0; i < groups * kGroupSize; ++i) {
+            buffer |= static_cast<std::uint64_t>(i < count ? values[i] : 0) << bits;
+            bits += bit_width;
+            while (bits >= 8) {
+                out.push_back(static_cast<char>(buffer));
+                buffer >>= 8;
+                bits -= 8;
+            }
+        }
+    }
+
+    // Bits packed at once, so that a partial byte and a chunk fit 64 bits.
+    constexpr unsigned kMaxChunkBits = 56;
+
+    std::uint64_t LowBits(std::uint64_t value, unsigned bits) {
+        return bits == 64 ? value : value & ((std::uint64_t(1) << bits) - 1);
+    }
+
+    // Bits of values LSB first, as PackBits stores them.
+    class BitWriter {
+    public:
+        explicit BitWriter(std::string& out)
+            : out_(out) {
+        }
+
+        void Put(std::uint64_t value, unsigned bit_width) {
+            for (unsigned remaining = bit_width; remaining > 0;) {
+                const auto chunk = std::min(remaining, kMaxChunkBits);
+                buffer_ |= LowBits(value, chunk) << bits_;
+                bits_ += chunk;
+                value >>= chunk;
+                remaining -= chunk;
+                while (bits_ >= 8) {
+                    out_.push_back(static_cast<char>(buffer_));
+                    buffer_ >>= 8;
+                    bits_ -= 8;
+                }
+            }
+        }
+
+        // Writes the last partial byte.
+        void Finish() {
+            if (bits_ > 0) {
+                out_.push_back(static_cast<char>(buffer_));
+                buffer_ = 0;
+                bits_ = 0;
+            }
+        }
+
+    private:
+        std::string& out_;
+        std::uint64_t buffer_ = 0;
+        unsigned bits_ = 0;
+    };
+
+    class BitReader {
+    public:
+        explicit BitReader(std::string_view bytes)
+            : bytes_(bytes) {
+        }
+
+        std::uint64_t Read(unsigned bit_width) {
+            std::uint64_t value = 0;
+            for (unsigned filled = 0; filled < bit_width;) {
+                const auto chunk = std::min(bit_width - filled, kMaxChunkBits);
+                while (bits_ < chunk) {
+                    if (byte_ == bytes_.size()) {
+                        throw std::runtime_error("Unexpected end of bit-packed values");
+                    }
+                    buffer_ |= static_cast<std::uint64_t>(static_cast<unsigned char>(bytes_[byte_++])) << bits_;
+                    bits_ += 8;
+                }
+                value |= LowBits(buffer_, chunk) << filled;
+                buffer_ >>= chunk;
+                bits_ -= chunk;
+                filled += chunk;
+            }
+            return value;
+        }
+
+        // Bytes holding the bits read so far.
+        std::size_t BytesRead() const {
+            return byte_;
+        }
+
+    private:
+        std::string_view bytes_;
+        std::size_t byte_ = 0;
+        std::uint64_t buffer_ = 0;
+        unsigned bits_ = 0;
+    };
+
+    // Widths unpacked by kernels, one unaligned 8-byte load covers any value.
+    constexpr unsigned kMaxKernelBitWidth = 56;
+    // Kernels load 8 bytes at the byte of a value, up to this many past a group.
+    constexpr std::size_t kKernelSlack = 8;
+
+    // Unpacks a group of kGroupSize values, which takes exactly kBitWidth
+    // bytes. Shifts and masks are constants and values do not depend on each
+    // other, so the compiler can unroll and vectorize the group.
+    template <unsigned kBitWidth, typename T, std::size_t... kIndices>
+    void UnpackGroup(const char* in, T* out, std::index_sequence<kIndices...>) {
+        constexpr auto mask = (std::uint64_t(1) << kBitWidth) - 1;
+        ((out[kIndices] = static_cast<T>((Load8Bytes(in + kIndices * kBitWidth / 8) >> (kIndices * kBitWidth % 8)) & mask)), ...);
+    }
+
+    template <unsigned kBitWidth, typename T>
+    void UnpackGroup(const char* in, T* out) {
+        UnpackGroup<kBitWidth>(in, out, std::make_index_sequence<kGroupSize>());
+    }
+
+    template <typename T>
+    using GroupUnpacker = void (*)(const char* in, T* out);
+
+    template <typename T, std::size_t... kWidths>
+    constexpr std::array<GroupUnpacker<T>, sizeof...(kWidths)> MakeGroupUnpackers(std::index_sequence<kWidths...>) {
+        return {&UnpackGroup<kWidths + 1, T>...};
+    }
+
+    // Unpacks whole groups from the start of in while kKernelSlack bytes past
+    // them are readable, returns the number of values unpacked. The rest is
+    // left to the caller, starting at a byte boundary.
+    template <typename T>
+    std::size_t UnpackGroups(const char* in, std::size_t readable, unsigned bit_width, std::size_t count, T* out) {
+        static constexpr auto kUnpackers = MakeGroupUnpackers<T>(std::make_index_sequence<kMaxKernelBitWidth>());
+        if (bit_width == 0 || bit_width > kMaxKernelBitWidth) {
+            return 0;
+        }
+        const auto unpack = kUnpackers[bit_width - 1];
+        std::size_t i = 0;
+        for (; i + kGroupSize <= count && (i / kGroupSize + 1) * bit_width + kKernelSlack <= readable; i += kGroupSize) {
+            unpack(in + i / kGroupSize * bit_width, out + i);
+        }
+        return i;
+    }
+
+    unsigned CountTrailingZeros(std::uint64_t value) {
+        unsigned count = 0;
+        while ((value & 1) == 0) {
+            value >>= 1;
+            ++count;
+        }
+        return count;
+    }
+
+    std::uint64_t LoadValue(const char* bytes, std::size_t value_size) {
+        return value_size == 4 ? Load4Bytes(bytes) : Load8Bytes(bytes);
+    }
+
+    void StoreValue(std::uint64_t value, std::size_t value_size, char* out) {
+        for (std::size_t i = 0; i < value_size; ++i) {
+            out[i] = static_cast<char>(value >> (8 * i));
+        }
+    }
+
+    unsigned PopCount(std::uint64_t value) {
+        value = value - ((value >> 1) & 0x5555555555555555);
+        value = (value & 0x3333333333333333) + ((value >> 2) & 0x3333333333333333);
+        value = (value + (value >> 4)) & 0x0f0f0f0f0f0f0f0f;
+        return (value * 0x0101010101010101) >> 56;
+    }
+
+    template <typename T>
+    void EncodeBits(const T* values, std::size_t count, std::string& out) {
+        const auto start = out.size();
+        out.resize(start + (count + 7) / 8);
+        for (std::size_t i = 0; i < count; ++i) {
+            out[start + i / 8] |= static_cast<char>((values[i] & 1) << (i % 8));
+        }
+    }
+
+    template <typename T>
+    void ExpandBits(std::string_view bitmap, std::size_t count, T* out) {
+        if (bitmap.size() < (count + 7) / 8) {
+            throw std::runtime_error("Bitmap is too short");
+        }
+        // Whole bytes expand without dependencies between outputs.
+        for (std::size_t byte = 0; byte < count / 8; ++byte) {
+            const auto bits = static_cast<unsigned char>(bitmap[byte]);
+            for (unsigned bit = 0; bit < 8; ++bit) {
+                out[byte * 8 + bit] = (bits >> bit) & 1;
+            }
+        }
+        for (auto i = count / 8 * 8; i < count; ++i) {
+            out[i] = (static_cast<unsigned char>(bitmap[i / 8]) >> (i % 8)) & 1;
+        }
+    }
+
+    void Put8Bytes(std::string& out, std::uint64_t value) {
+        for (int i = 0; i < 8; ++i) {
+            out.push_back(static_cast<char>(value >> (8 * i)));
+        }
+    }
+
+    std::int64_t WrappingSub(std::int64_t lhs, std::int64_t rhs) {
+        return static_cast<std::int64_t>(static_cast<std::uint64_t>(lhs) - static_cast<std::uint64_t>(rhs));
+    }
+
+    std::int64_t WrappingAdd(std::int64_t lhs, std::int64_t rhs) {
+        return static_cast<std::int64_t>(static_cast<std::uint64_t>(lhs) + static_cast<std::uint64_t>(rhs));
+    }
+
+    void PrefixSum(std::int64_t first, std::size_t count, std::int64_t* values) {
+        for (std::size_t i = 0; i < count; ++i) {
+            first = WrappingAdd(first, values[i]);
+            values[i] = first;
+        }
+    }
+
+} // namespace
+
+void PutVarint(std::string& out, std::uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+std::uint64_t ReadVarint(SpanCursor& input) {
+    std::uint64_t value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        char byte;
+        input.Get(byte);
+        value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+    }
+    throw std::runtime_error("Malformed varint");
+}
+
+unsigned BitWidth(std::uint64_t max_value) {
+    unsigned width = 0;
+    while (max_value != 0) {
+        ++width;
+        max_value >>= 1;
+    }
+    return width;
+}
+
+void EncodeRleBitPacked(const std::uint32_t* values, std::size_t count, unsigned bit_width, std::string& out) {
+    if (bit_width == 0) {
+        return;
+    }
+    std::size_t i = 0;
+    while (i < count) {
+        const auto run = RunLength(values, count, i);
+        if (run >= kMinRunLength) {
+            PutRun(out, values[i], run, bit_width);
+            i += run;
+            continue;
+        }
+        // Bit-pack whole groups until one starts a long run.
+        auto end = std::min(i + kGroupSize, count);
+        while (end < count && RunLength(values, count, end) < kMinRunLength) {
+            end = std::min(end + kGroupSize, count);
+        }
+        PutBitPacked(out, values + i, end - i, bit_width);
+        i = end;
+    }
+}
+
+void DecodeRleBitPacked(SpanCursor& input, unsigned bit_width, std::size_t count, std::uint32_t* out) {
+    if (bit_width == 0) {
+        std::fill(out, out + count, 0);
+        return;
+    }
+    const auto mask = bit_width == 32 ? ~std::uint32_t(0) : (std::uint32_t(1) << bit_width) - 1;
+    std::size_t decoded = 0;
+    while (decoded < count) {
+        const auto header = ReadVarint(input);
+        if (header >> 1 == 0) {
+            throw std::runtime_error("Malformed run of levels");
+        }
+        if ((header & 1) == 0) {
+            const auto length = std::min<std::size_t>(header >> 1, count - decoded);
+            std::uint32_t value = 0;
+            const auto bytes = input.ReadView((bit_width + 7) / 8);
+            for (std::size_t i = 0; i < bytes.size(); ++i) {
+                value |= static_cast<std::uint32_t>(static_cast<unsigned char>(bytes[i])) << (8 * i);
+            }
+            std::fill(out + decoded, out + decoded + length, value);
+            decoded += length;
+            continue;
+        }
+
+        const auto groups = header >> 1;
+        const auto bytes = input.ReadView(groups * bit_width);
+        const auto length = std::min<std::size_t>(groups * kGroupSize, count - decoded);
+        // The cursor is contiguous, kernels may load the bytes following the run.
+        auto i = UnpackGroups(bytes.data(), bytes.size() + input.Remaining(), bit_width, length, out + decoded);
+        std::uint64_t buffer = 0;
+        unsigned bits = 0;
+        auto byte = i / kGroupSize * bit_width;
+        for (; i < length; ++i) {
+            while (bits < bit_width) {
+                buffer |= static_cast<std::uint64_t>(static_cast<unsigned char>(bytes[byte++])) << bits;
+                bits += 8;
+            }
+            out[decoded + i] = static_cast<std::uint32_t>(buffer) & mask;
+            buffer >>= bit_width;
+            bits -= bit_width;
+        }
+        decoded += length;
+    }
+}
+
+void PackBits(const std::uint64_t* values, std::size_t count, unsigned bit_width, std::string& out) {
+    BitWriter writer(out);
+    for (std::size_t i = 0; i < count; ++i) {
+        writer.Put(values[i], bit_width);
+    }
+    writer.Finish();
+}
+
+void UnpackBits(SpanCursor& input, unsigned bit_width, std::size_t count, std::uint64_t* out) {
+    if (bit_width > 64) {
+        throw std::runtime_error("Malformed bit width");
+    }
+    const auto bytes = input.ReadView((count * bit_width + 7) / 8);
+    auto i = UnpackGroups(bytes.data(), bytes.size() + input.Remaining(), bit_width, count, out);
+    BitReader reader(bytes.substr(i / kGroupSize * bit_width));
+    for (; i < count; ++i) {
+        out[i] = reader.Read(bit_width);
+    }
+}
+
+void EncodeBitmap(const std::uint32_t* values, std::size_t count, std::string& out) {
+    EncodeBits(values, count, out);
+}
+
+void EncodeBitmap(const char* values, std::size_t count, std::string& out) {
+    EncodeBits(values, count, out);
+}
+
+std::size_t CountBits(std::string_view bitmap, std::size_t count) {
+    if (bitmap.size() < (count + 7) / 8) {
+        throw std::runtime_error("Bitmap is too short");
+    }
+    std::size_t bits = 0;
+    std::size_t byte = 0;
+    for (; byte + 8 <= count / 8; byte += 8) {
+        bits += PopCount(Load8Bytes(bitmap.data() + byte));
+    }
+    for (; byte < count / 8; ++byte) {
+        bits += PopCount(static_cast<unsigned char>(bitmap[byte]));
+    }
+    if (count % 8 != 0) {
+        bits += PopCount(static_cast<unsigned char>(bitmap[byte]) & ((1u << (count % 8)) - 1));
+    }
+    return bits;
+}
+
+void ExpandBitmap(std::string_view bitmap, std::size_t count, std::uint32_t* out) {
+    ExpandBits(bitmap, count, out);
+}
+
+void ExpandBitmap(std::string_view bitmap, std::size_t count, char* out) {
+    ExpandBits(bitmap, count, out);
+}
+
+void EncodeFrameOfReference(const std::int64_t* values, std::size_t count, std::string& out) {
+    const auto [min, max] = count == 0 ? std::pair<const std::int64_t*, const std::int64_t*>() : std::minmax_element(values, values + count);
+    const auto reference = count == 0 ? 0 : *min;
+    const auto bit_width = count == 0 ? 0 : BitWidth(static_cast<std::uint64_t>(WrappingSub(*max, reference)));
+    std::vector<std::uint64_t> offsets(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        offsets[i] = static_cast<std::uint64_t>(WrappingSub(values[i], reference));
+    }
+    Put8Bytes(out, static_cast<std::uint64_t>(reference));
+    out.push_back(static_cast<char>(bit_width));
+    PackBits(offsets.data(), count, bit_width, out);
+}
+
+void DecodeFrameOfReference(SpanCursor& input, std::size_t count, std::int64_t* out) {
+    const auto reference = static_cast<std::int64_t>(Read8Bytes(input));
+    char bit_width;
+    input.Get(bit_width);
+    static_assert(sizeof(std::int64_t) == sizeof(std::uint64_t));
+    auto* offsets = reinterpret_cast<std::uint64_t*>(out);
+    UnpackBits(input, static_cast<unsigned char>(bit_width), count, offsets);
+    for (std::size_t i = 0; i < count; ++i) {
+        out[i] = WrappingAdd(reference, static_cast<std::int64_t>(offsets[i]));
+    }
+}
+
+void EncodeDelta(const std::int64_t* values, std::size_t count, std::string& out) {
+    std::vector<std::int64_t> deltas;
+    for (std::size_t i = 1; i < count; ++i) {
+        deltas.push_back(WrappingSub(values[i], values[i - 1]));
+    }
+    Put8Bytes(out, count == 0 ? 0 : static_cast<std::uint64_t>(values[0]));
+    EncodeFrameOfReference(deltas.data(), deltas.size(), out);
+}
+
+void DecodeDelta(SpanCursor& input, std::size_t count, std::int64_t* out) {
+    const auto first = static_cast<std::int64_t>(Read8Bytes(input));
+    if (count == 0) {
+        DecodeFrameOfReference(input, 0, out);
+        return;
+    }
+    out[0] = first;
+    DecodeFrameOfReference(input, count - 1, out + 1);
+    PrefixSum(first, count - 1, out + 1);
+}
+
+void EncodeDeltaOfDelta(const std::int64_t* values, std::size_t count, std::string& out) {
+    std::vector<std::int64_t> deltas;
+    for (std::size_t i = 2; i < count; ++i) {
+        deltas.push_back(WrappingSub(WrappingSub(values[i], values[i - 1]), WrappingSub(values[i - 1], values[i - 2])));
+    }
+    Put8Bytes(out, count == 0 ? 0 : static_cast<std::uint64_t>(values[0]));
+    Put8Bytes(out, count < 2 ? 0 : static_cast<std::uint64_t>(WrappingSub(values[1], values[0])));
+    EncodeFrameOfReference(deltas.data(), deltas.size(), out);
+}
+
+void DecodeDeltaOfDelta(SpanCursor& input, std::size_t count, std::int64_t* out) {
+    const auto first = static_cast<std::int64_t>(Read8Bytes(input));
+    const auto first_delta = static_cast<std::int64_t>(Read8Bytes(input));
+    if (count < 2) {
+        DecodeFrameOfReference(input, 0, out);
+        if (count == 1) {
+            out[0] = first;
+        }
+        return;
+    }
+    out[0] = first;
+    out[1] = first_delta;
+    DecodeFrameOfReference(input, count - 2, out + 2);
+    // Deltas first, then values.
+    PrefixSum(first_delta, count - 2, out + 2);
+    PrefixSum(first, count - 1, out + 1);
+}
+
+void EncodeByteStreamSplit(const char* values, std::size_t count, std::size_t value_size, std::string& out) {
+    const auto start = out.size();
+    out.resize(start + count * value_size);
+    for (std::size_t i = 0; i < count; ++i) {
+        for (std::size_t byte = 0; byte < value_size; ++byte) {
+            out[start + byte * count + i] = values[i * value_size + byte];
+        }
+    }
+}
+
+void DecodeByteStreamSplit(SpanCursor& input, std::size_t count, std::size_t value_size, char* out) {
+    const auto streams = input.ReadView(count * value_size);
+    for (std::size_t byte = 0; byte < value_size; ++byte) {
+        const auto* stream = streams.data() + byte * count;
+        for (std::size_t i = 0; i < count; ++i) {
+            out[i * value_size + byte] = stream[i];
+        }
+    }
+}
+
+void EncodeGorilla(const char* values, std::size_t count, std::size_t value_size, std::string& out) {
+    if (count == 0) {
+        return;
+    }
+    const unsigned bits = 8 * value_size;
+    const unsigned field_width = value_size == 4 ? 5 : 6;
+    BitWriter writer(out);
+    auto previous = LoadValue(values, value_size);
+    writer.Put(previous, bits);
+    // No window until the first value that differs.
+    unsigned window_leading = bits;
+    unsigned window_trailing = 0;
+    for (std::size_t i = 1; i < count; ++i) {
+        const auto value = LoadValue(values + i * value_size, value_size);
+        const auto xored = value ^ previous;
+        previous = value;
+        if (xored == 0) {
+            writer.Put(0, 1);
+            continue;
+        }
+        const auto leading = bits - BitWidth(xored);
+        const auto trailing = CountTrailingZeros(xored);
+        if (window_leading != bits && leading >= window_leading && trailing >= window_trailing) {
+            writer.Put(0b01, 2);
+            writer.Put(xored >> window_trailing, bits - window_leading - window_trailing);
+            continue;
+        }
+        const auto length = bits - leading - trailing;
+        writer.Put(0b11, 2);
+        writer.Put(leading, field_width);
+        writer.Put(length - 1, field_width);
+        writer.Put(xored >> trailing, length);
+        window_leading = leading;
+        window_trailing = trailing;
+    }
+    writer.Finish();
+}
+
+void DecodeGorilla(SpanCursor& input, std::size_t count, std::size_t value_size, char* out) {
+    if (count == 0) {
+        return;
+    }
+    const unsigned bits = 8 * value_size;
+    const unsigned field_width = value_size == 4 ? 5 : 6;
+    const auto remaining = input.Remaining();
+    BitReader reader(input.ReadView(remaining));
+    auto previous = reader.Read(bits);
+    StoreValue(previous, value_size, out);
+    unsigned window_leading = bits;
+    unsigned window_trailing = 0;
+    for (std::size_t i = 1; i < count; ++i) {
+        if (reader.Read(1) != 0) {
+            if (reader.Read(1) != 0) {
+                window_leading = reader.Read(field_width);
+                const auto length = reader.Read(field_width) + 1;
+                if (window_leading + length > bits) {
+                    throw std::runtime_error("Malformed XOR window");
+                }
+                window_trailing = bits - window_leading - length;
+            } else if (window_leading == bits) {
+                throw std::runtime_error("Malformed XOR window");
+            }
+            previous ^= reader.Read(bits - window_leading - window_trailing) << window_trailing;
+        }
+        StoreValue(previous, value_size, out + i * value_size);
+    }
+    input.Seekg(-static_cast<std::ptrdiff_t>(remaining - reader.BytesRead()));
+}
+
+} // namespace lib::chunk_impl::dremel
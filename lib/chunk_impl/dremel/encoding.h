@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <lib/chunk_impl/io.h>
+
+namespace lib::chunk_impl::dremel {
+
+// Unsigned LEB128.
+void PutVarint(std::string& out, std::uint64_t value);
+std::uint64_t ReadVarint(SpanCursor& input);
+
+// Bits needed for values up to max_value, 0 when every value is 0.
+unsigned BitWidth(std::uint64_t max_value);
+
+// Hybrid of run-length encoding and bit-packing for small integers such as
+// repetition and definition levels. The stream is a sequence of runs, each
+// starting with a varint header:
+//   (count << 1)     count copies of a value stored in ceil(bit_width / 8) bytes
+//   (groups << 1)|1  groups of 8 values, bit_width bits each, LSB first
+// Nothing is stored for bit_width 0. The number of values is kept by the
+// caller, the last bit-packed group is padded with zeros.
+void EncodeRleBitPacked(const std::uint32_t* values, std::size_t count, unsigned bit_width, std::string& out);
+// Decodes count values at once.
+void DecodeRleBitPacked(SpanCursor& input, unsigned bit_width, std::size_t count, std::uint32_t* out);
+
+// Values of bit_width bits each, LSB first, the last byte padded with zeros.
+void PackBits(const std::uint64_t* values, std::size_t count, unsigned bit_width, std::string& out);
+void UnpackBits(SpanCursor& input, unsigned bit_width, std::size_t count, std::uint64_t* out);
+
+// One bit per value, LSB first, for values 0 and 1 such as validity of rows
+// and booleans.
+void EncodeBitmap(const std::uint32_t* values, std::size_t count, std::string& out);
+void EncodeBitmap(const char* values, std::size_t count, std::string& out);
+// Number of set bits among the first count bits.
+std::size_t CountBits(std::string_view bitmap, std::size_t count);
+// Expands the first count bits into values 0 and 1.
+void ExpandBitmap(std::string_view bitmap, std::size_t count, std::uint32_t* out);
+void ExpandBitmap(std::string_view bitmap, std::size_t count, char* out);
+
+// Integer encodings, the number of values is kept by the caller. Arithmetic
+// wraps, so any int64 values round-trip.
+//   frame of reference: min (8 bytes) | bit width (1 byte) | packed value - min
+//   delta:              first value (8 bytes) | frame of reference of deltas
+//   delta of delta:     first value | first delta (8 bytes each) |
+//                       frame of reference of deltas of deltas
+void EncodeFrameOfReference(const std::int64_t* values, std::size_t count, std::string& out);
+void DecodeFrameOfReference(SpanCursor& input, std::size_t count, std::int64_t* out);
+void EncodeDelta(const std::int64_t* values, std::size_t count, std::string& out);
+void DecodeDelta(SpanCursor& input, std::size_t count, std::int64_t* out);
+void EncodeDeltaOfDelta(const std::int64_t* values, std::size_t count, std::string& out);
+void DecodeDeltaOfDelta(SpanCursor& input, std::size_t count, std::int64_t* out);
+
+// Floating-point encodings of count little-endian values of value_size (4 or
+// 8) bytes, decoded back into the same plain bytes.
+//   byte stream split: value_size streams, the i-th holds the i-th byte of
+//                      every value, so that a generic codec compresses them
+//                      better
+//   Gorilla:           first value, then per value its XOR with the previous
+//                      one: bit 0 when equal, bits 1 0 and the meaningful bits
+//                      when they fit the previous window, else bits 1 1,
+//                      leading zeros, length - 1 (5 bits each for 4-byte
+//                      values, 6 for 8-byte ones) and the meaningful bits.
+//                      Bits are packed LSB first as in PackBits
+void EncodeByteStreamSplit(const char* values, std::size_t count, std::size_t value_size, std::string& out);
+void DecodeByteStreamSplit(SpanCursor& input, std::size_t count, std::size_t value_size, char* out);
+void EncodeGorilla(const char* values, std::size_t count, std::size_t value_size, std::string& out);
+void DecodeGorilla(SpanCursor& input, std::size_t count, std::size_t value_size, char* out);
+
+} // namespace lib::chunk_impl::dremel
@@ -6,19 +6,36 @@
 
 namespace lib::chunk_impl::dremel {
 
+PhysicalType ParsePhysicalType(const std::string& name) {
+    if (name == "int") {
+        return PhysicalType::Int;
+    } else if (name == "double") {
+        return PhysicalType::Double;
+    } else if (name == "bool") {
+        return PhysicalType::Bool;
+    } else if (name == "string") {
+        return PhysicalType::String;
+    } else {
+        return PhysicalType::Tagged;
+    }
+}
+
 FieldDescriptor::FieldDescriptor(
     const std::shared_ptr<FieldDescriptor>& parent,
     const std::string& field_name,
     FieldLabel field_label,
     FieldType field_type,
     RepetitionLevel max_repetition_level,
-    DefinitionLevel definition_level)
+    DefinitionLevel definition_level,
+    PhysicalType physical_type)
     : parent_(parent)
     , field_name_(field_name)
+    , field_key_(document::InternKey(field_name))
     , field_label_(field_label)
     , field_type_(field_type)
     , max_repetition_level_(max_repetition_level)
-    , definition_level_(definition_level) {
+    , definition_level_(definition_level)
+    , physical_type_(physical_type) {
     field_hash_ = std::hash<std::string>()(ConstructPath());
 }
 
@@ -29,6 +46,9 @@ void FieldDescriptor::AddChild(const std::shared_ptr<FieldDescriptor>& child) {
 std::string FieldDescriptor::GetFieldName() const {
     return field_name_;
 }
+document::KeyId FieldDescriptor::GetFieldKey() const {
+    return field_key_;
+}
 FieldLabel FieldDescriptor::GetFieldLabel() const {
     return field_label_;
 }
@@ -41,11 +61,16 @@ RepetitionLevel FieldDescriptor::GetMaxRepetitionLevel() const {
 DefinitionLevel FieldDescriptor::GetDefinitionLevel() const {
     return definition_level_;
 }
+
+PhysicalType FieldDescriptor::GetPhysicalType() const {
+    return physical_type_;
+}
+
 FieldHashType FieldDescriptor::GetFieldHash() const {
     return field_hash_;
 }
 FieldDescriptorPtr FieldDescriptor::GetParent() const {
-    return parent_;
+    return parent_.lock();
 }
 const std::vector<FieldDescriptorPtr>& FieldDescriptor::GetChildren() const {
     return children_;
@@ -55,7 +80,7 @@ bool FieldDescriptor::IsLeaf() const {
     return field_type_ == FieldType::Primitive;
 }
 bool FieldDescriptor::IsRoot() const {
-    return parent_ == nullptr;
+    return parent_.expired();
 }
 bool FieldDescriptor::HasAnyChild() const {
     return !children_.empty();
@@ -65,7 +90,7 @@ std::string FieldDescriptor::ConstructPath() const {
     if (IsRoot()) {
         return "";
     }
-    return parent_->ConstructPath() + "." + field_name_;
+    return GetParent()->ConstructPath() + "." + field_name_;
 }
 std::string FieldDescriptor::ToString() const {
     std::ostringstream oss;
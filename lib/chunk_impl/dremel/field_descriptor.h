@@ -6,6 +6,8 @@
 #include <string>
 #include <vector>
 
+#include <lib/document/key_table.h>
+
 namespace lib::chunk_impl::dremel {
 
 enum class FieldLabel {
@@ -19,20 +21,36 @@ enum class FieldType {
     Object,
 };
 
+// Leaf value type declared in schema ("int", "double", "bool", "string").
+// Values of other types are still written, tagged with their type.
+enum class PhysicalType {
+    Tagged,
+    Int,
+    Double,
+    Bool,
+    String,
+};
+
+// Unknown names are Tagged.
+PhysicalType ParsePhysicalType(const std::string& name);
+
 using FieldHashType = std::size_t;
 using RepetitionLevel = std::uint32_t;
 using DefinitionLevel = std::uint16_t;
 
 class FieldDescriptor {
 protected:
-    std::shared_ptr<FieldDescriptor> parent_;
+    // Weak, so that the tree is released with its root and leaf streams get closed.
+    std::weak_ptr<FieldDescriptor> parent_;
     std::vector<std::shared_ptr<FieldDescriptor>> children_;
 
     std::string field_name_;
+    document::KeyId field_key_;
     FieldLabel field_label_;
     FieldType field_type_;
     RepetitionLevel max_repetition_level_;
     DefinitionLevel definition_level_;
+    PhysicalType physical_type_;
 
     FieldHashType field_hash_;
 
@@ -49,15 +67,18 @@ public:
         FieldLabel field_label,
         FieldType field_type,
         RepetitionLevel max_repetition_level,
-        DefinitionLevel definition_level);
+        DefinitionLevel definition_level,
+        PhysicalType physical_type = PhysicalType::Tagged);
 
     std::shared_ptr<FieldDescriptor> GetParent() const;
     const std::vector<std::shared_ptr<FieldDescriptor>>& GetChildren() const;
     std::string GetFieldName() const;
+    document::KeyId GetFieldKey() const;
     FieldLabel GetFieldLabel() const;
     FieldType GetFieldType() const;
     RepetitionLevel GetMaxRepetitionLevel() const;
     DefinitionLevel GetDefinitionLevel() const;
+    PhysicalType GetPhysicalType() const;
     FieldHashType GetFieldHash() const;
 
     void AddChild(const std::shared_ptr<FieldDescriptor>& child);
@@ -6,6 +6,27 @@
 
 namespace lib::chunk_impl::dremel {
 
+namespace {
+
+    template <typename Input>
+    Row ReadRowFrom(Input& input, const document::ArenaPtr& arena, bool borrow_strings) {
+        const auto r = Read4Bytes(input);
+        const auto d = Read2Bytes(input);
+        const auto cch = ReadControlChar(input);
+        const auto value = ReadPrimitiveValue(*cch, input, arena, borrow_strings);
+
+        return Row{r, d, value};
+    }
+
+    template <typename Input>
+    RepetitionLevel PeekRepetitionLevel(Input& input) {
+        const auto r = Read4Bytes(input);
+        input.Seekg(-4);
+        return r;
+    }
+
+} // namespace
+
 FieldReader::FieldReader(
     const std::shared_ptr<std::string>& chunk_path,
     const std::shared_ptr<FieldReader>& parent,
@@ -13,8 +34,9 @@ FieldReader::FieldReader(
     FieldLabel field_label,
     FieldType field_type,
     RepetitionLevel max_repetition_level,
-    DefinitionLevel definition_level)
-    : FieldDescriptor(std::static_pointer_cast<FieldDescriptor>(parent), field_name, field_label, field_type, max_repetition_level, definition_level)
+    DefinitionLevel definition_level,
+    PhysicalType physical_type)
+    : FieldDescriptor(std::static_pointer_cast<FieldDescriptor>(parent), field_name, field_label, field_type, max_repetition_level, definition_level, physical_type)
     , chunk_path_(chunk_path) {
     field_index_ = SIZE_MAX;
 }
@@ -24,16 +46,71 @@ std::shared_ptr<IStream> FieldReader::GetOrCreateStream() {
         return stream;
     }
 
-    auto path = std::filesystem::path(*chunk_path_).append(ConstructPath()).string();
-    stream = GetInputStream(path);
+    SetStream(GetInputStream(GetFilePath()));
     return stream;
 }
 
+void FieldReader::SetStream(const std::shared_ptr<IStream>& leaf_stream) {
+    stream = leaf_stream;
+    cursor_.reset();
+    if (const auto memory_reader = std::dynamic_pointer_cast<MemoryReader>(stream)) {
+        cursor_ = memory_reader->GetCursor();
+    }
+    DetectFormat();
+}
+
+void FieldReader::DetectFormat() {
+    page_.reset();
+    char magic[kPagedColumnMagic.size()];
+    if (cursor_.has_value()) {
+        if (cursor_->Remaining() < sizeof(magic)) {
+            return;
+        }
+        cursor_->Read(magic, sizeof(magic));
+    } else {
+        if (stream->Eof()) {
+            return;
+        }
+        stream->Read(magic, sizeof(magic));
+    }
+    if (std::string_view(magic, sizeof(magic)) == kPagedColumnMagic) {
+        page_.emplace(max_repetition_level_, definition_level_, physical_type_);
+    } else if (cursor_.has_value()) {
+        cursor_->Seekg(-static_cast<std::ptrdiff_t>(sizeof(magic)));
+    } else {
+        stream->Seekg(-static_cast<int>(sizeof(magic)));
+    }
+}
+
+bool FieldReader::LoadPage() {
+    if (cursor_.has_value()) {
+        if (cursor_->Eof()) {
+            return false;
+        }
+        page_->Load(*cursor_);
+        return true;
+    }
+    if (stream->Eof()) {
+        return false;
+    }
+    page_buffer_.resize(kPageHeaderSize);
+    stream->Read(page_buffer_.data(), kPageHeaderSize);
+    page_buffer_.resize(GetPageSize(page_buffer_.data()));
+    stream->Read(page_buffer_.data() + kPageHeaderSize, page_buffer_.size() - kPageHeaderSize);
+    SpanCursor page_cursor(page_buffer_.data(), page_buffer_.data() + page_buffer_.size());
+    page_->Load(page_cursor);
+    return true;
+}
+
+std::string FieldReader::GetFilePath() const {
+    return std::filesystem::path(*chunk_path_).append(ConstructPath()).string();
+}
+
 std::shared_ptr<std::string> FieldReader::GetChunkPath() const {
     return chunk_path_;
 }
 
-Row FieldReader::ReadRow() {
+Row FieldReader::ReadRow(const document::ArenaPtr& arena, bool borrow_strings) {
     if (!IsLeaf()) {
         throw std::logic_error("Only leaf nodes are allowed to call ReadMeta()");
     }
@@ -41,25 +118,49 @@ Row FieldReader::ReadRow() {
         throw std::logic_error("Called ReadRow when reader on EOF");
     }
 
-    const auto r = Read4Bytes(*stream);
-    const auto d = Read2Bytes(*stream);
-    const auto cch = ReadControlChar(*stream);
-    const auto value = ReadPrimitiveValue(*cch, *stream);
+    borrow_strings = borrow_strings && arena != nullptr && stream->SupportsViews();
+    if (page_.has_value()) {
+        RepetitionLevel r;
+        DefinitionLevel d;
+        const auto has_value = page_->Next(r, d);
+        // Pages copied out of the stream are overwritten by the next one.
+        borrow_strings = borrow_strings && cursor_.has_value();
+        return Row{r, d, has_value ? page_->ReadValue(arena, borrow_strings) : std::static_pointer_cast<document::Value>(document::MakeValue<document::Null>(arena))};
+    }
+    if (cursor_.has_value()) {
+        return ReadRowFrom(*cursor_, arena, borrow_strings);
+    }
+    return ReadRowFrom(*stream, arena, borrow_strings);
+}
 
-    return Row{
-        .repetition_level = r,
-        .definition_level = d,
-        .value = value,
-    };
+const std::vector<std::string_view>* FieldReader::GetDictionary() {
+    if (!IsLeaf() || IsDone() || !page_.has_value()) {
+        return nullptr;
+    }
+    return page_->GetDictionary();
+}
+
+DictionaryRow FieldReader::ReadDictionaryRow() {
+    if (GetDictionary() == nullptr) {
+        throw std::logic_error("Called ReadDictionaryRow when next row is not dictionary encoded");
+    }
+    RepetitionLevel r;
+    DefinitionLevel d;
+    const auto has_value = page_->Next(r, d);
+    return DictionaryRow{r, d, has_value ? std::optional<std::uint32_t>(page_->ReadDictionaryId()) : std::nullopt};
 }
 
 RepetitionLevel FieldReader::NextRepetitionLevel() {
     if (IsDone()) {
         return 0;
     }
-    const auto r = Read4Bytes(*stream);
-    stream->Seekg(-4);
-    return r;
+    if (page_.has_value()) {
+        return page_->PeekRepetitionLevel();
+    }
+    if (cursor_.has_value()) {
+        return PeekRepetitionLevel(*cursor_);
+    }
+    return PeekRepetitionLevel(*stream);
 }
 
 std::size_t FieldReader::GetFieldIndex() const {
@@ -81,7 +182,13 @@ bool FieldReader::IsDone() {
         throw std::logic_error("Tried to check IsDone on non-leaf node");
     }
     stream = GetOrCreateStream();
-    return stream->Peek() == EOF;
+    if (page_.has_value()) {
+        return !page_->HasRows() && !LoadPage();
+    }
+    if (cursor_.has_value()) {
+        return cursor_->Eof();
+    }
+    return stream->Eof();
 }
 
 } // namespace lib::chunk_impl::dremel
@@ -1,7 +1,11 @@
 #pragma once
 
+#include <optional>
+
 #include <lib/chunk_impl/dremel/field_descriptor.h>
+#include <lib/chunk_impl/dremel/page.h>
 #include <lib/chunk_impl/io.h>
+#include <lib/document/arena.h>
 #include <lib/document/document.h>
 
 namespace lib::chunk_impl::dremel {
@@ -12,11 +16,26 @@ struct Row {
     const std::shared_ptr<document::Value> value;
 };
 
+struct DictionaryRow {
+    const RepetitionLevel repetition_level;
+    const DefinitionLevel definition_level;
+    // Index in the dictionary of the page, unset for rows without value.
+    const std::optional<std::uint32_t> id;
+};
+
 class FieldReader: public FieldDescriptor {
 private:
     std::size_t field_index_;
     std::shared_ptr<std::string> chunk_path_;
-    std::shared_ptr<IStream> GetOrCreateStream();
+    // Set for leaf files held in memory, rows are decoded through it instead of stream.
+    std::optional<SpanCursor> cursor_;
+    // Set for columns in the paged format, see kPagedColumnMagic.
+    std::optional<PageReader> page_;
+    // Page read from a stream that does not hold the column in memory.
+    std::vector<char> page_buffer_;
+
+    void DetectFormat();
+    bool LoadPage();
 
 public:
     FieldReader() = delete;
@@ -34,15 +53,29 @@ public:
         FieldLabel field_label,
         FieldType field_type,
         RepetitionLevel max_repetition_level,
-        DefinitionLevel definition_level);
+        DefinitionLevel definition_level,
+        PhysicalType physical_type = PhysicalType::Tagged);
 
+    std::shared_ptr<IStream> GetOrCreateStream();
+    // For leaf files opened ahead, see ReadFiles.
+    void SetStream(const std::shared_ptr<IStream>& leaf_stream);
+    std::string GetFilePath() const;
     bool IsDone();
     RepetitionLevel NextRepetitionLevel();
     std::shared_ptr<std::string> GetChunkPath() const;
     std::size_t GetFieldIndex() const;
     void SetFieldIndex(std::size_t index);
 
-    Row ReadRow();
+    // With borrow_strings, string values reference the leaf file mapping, the
+    // caller retains it in arena (see RecordReader::SetArena).
+    Row ReadRow(const document::ArenaPtr& arena = nullptr, bool borrow_strings = false);
+    // Dictionary of the page holding the next row, nullptr if the page is not
+    // dictionary encoded. Valid until the next page is loaded, i.e. while
+    // rows are read by ReadDictionaryRow and this returns the same pointer.
+    const std::vector<std::string_view>* GetDictionary();
+    // Reads the next row as ReadRow without materializing its string, e.g.
+    // to compare ids with the id of a filter value. Requires GetDictionary().
+    DictionaryRow ReadDictionaryRow();
 };
 
 using FieldReaderPtr = std::shared_ptr<FieldReader>;
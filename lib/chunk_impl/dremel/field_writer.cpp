@@ -2,8 +2,6 @@
 
 #include <filesystem>
 
-#include <lib/chunk_impl/common.h>
-
 namespace lib::chunk_impl::dremel {
 
 FieldWriter::FieldWriter(
@@ -13,9 +11,11 @@ FieldWriter::FieldWriter(
     FieldLabel field_label,
     FieldType field_type,
     RepetitionLevel max_repetition_level,
-    DefinitionLevel definition_level)
-    : FieldDescriptor(std::static_pointer_cast<FieldDescriptor>(parent), field_name, field_label, field_type, max_repetition_level, definition_level)
-    , chunk_path_(chunk_path) {
+    DefinitionLevel definition_level,
+    PhysicalType physical_type)
+    : FieldDescriptor(std::static_pointer_cast<FieldDescriptor>(parent), field_name, field_label, field_type, max_repetition_level, definition_level, physical_type)
+    , chunk_path_(chunk_path)
+    , page_(max_repetition_level, definition_level, physical_type) {
 }
 
 std::shared_ptr<OStream> FieldWriter::GetOrCreateStream() {
@@ -23,11 +23,38 @@ std::shared_ptr<OStream> FieldWriter::GetOrCreateStream() {
         return stream;
     }
 
-    auto path = std::filesystem::path(*chunk_path_).append(ConstructPath()).string();
-    stream = GetOutputStream(path);
+    // Synced with the whole chunk, see FlushAll.
+    stream = GetOutputStream(GetFilePath(), 0, Durability::None);
     return stream;
 }
 
+std::string FieldWriter::GetFilePath() const {
+    return std::filesystem::path(*chunk_path_).append(ConstructPath()).string();
+}
+
+void FieldWriter::SetStream(const std::shared_ptr<OStream>& leaf_stream) {
+    stream = leaf_stream;
+    magic_written_ = false;
+    values_count_ = 0;
+}
+
+void FieldWriter::SetSplitFloatBytes(bool split_float_bytes) {
+    page_.SetSplitFloatBytes(split_float_bytes);
+}
+
+void FieldWriter::WritePage() {
+    auto stream = GetOrCreateStream();
+    if (!magic_written_) {
+        stream->Write(kPagedColumnMagic.data(), kPagedColumnMagic.size());
+        magic_written_ = true;
+    }
+    page_.WriteTo(*stream);
+}
+
+std::uint64_t FieldWriter::GetValuesCount() const {
+    return values_count_;
+}
+
 void FieldWriter::WriteNull(RepetitionLevel r, DefinitionLevel d) {
     // std::cerr << ConstructPath() << " in WriteNull "
     //           << " r=" << r << " d=" << d << '\n';
@@ -45,14 +72,11 @@ void FieldWriter::WritePrimitiveImpl(RepetitionLevel r, DefinitionLevel d, const
     if (value == nullptr) {
         return WriteNull(r, d);
     }
-    auto res = Serialize4Bytes(r);
-    auto d_serialized = Serialize2Bytes(d);
-    auto value_serialized = SerializePrimitiveValue(value);
-    res.insert(res.end(), d_serialized.begin(), d_serialized.end());
-    res.insert(res.end(), value_serialized.begin(), value_serialized.end());
-
-    auto stream = GetOrCreateStream();
-    stream->Write(res.data(), res.size());
+    page_.Add(r, d, *value);
+    ++values_count_;
+    if (page_.IsFull()) {
+        WritePage();
+    }
 }
 
 void FieldWriter::WriteImpl(RepetitionLevel r, DefinitionLevel d, const std::shared_ptr<document::Value>& value) {
@@ -64,11 +88,11 @@ void FieldWriter::WriteImpl(RepetitionLevel r, DefinitionLevel d, const std::sha
     if (field_label_ == FieldLabel::Optional) {
         const auto doc = std::static_pointer_cast<document::Document>(value);
 
-        const auto val_it = doc->value.find(field_name_);
-        const auto local_d = (val_it != doc->value.end() && !val_it->second->IsNull()) ? d + 1 : d;
+        const auto val_it = doc->value.find(field_key_);
+        const auto local_d = (val_it != doc->value.end() && !val_it->value->IsNull()) ? d + 1 : d;
         std::optional<std::shared_ptr<document::Value>> val;
-        if (val_it != doc->value.end() && !val_it->second->IsNull()) {
-            val = val_it->second;
+        if (val_it != doc->value.end() && !val_it->value->IsNull()) {
+            val = val_it->value;
         }
 
         if (field_type_ == FieldType::Object) {
@@ -82,12 +106,12 @@ void FieldWriter::WriteImpl(RepetitionLevel r, DefinitionLevel d, const std::sha
         }
     } else {
         const auto doc = std::static_pointer_cast<document::Document>(value);
-        const auto list_it = doc->value.find(field_name_);
-        if (list_it == doc->value.end() || list_it->second->IsNull()) {
+        const auto list_it = doc->value.find(field_key_);
+        if (list_it == doc->value.end() || list_it->value->IsNull()) {
             WriteNull(r, d);
             return;
         }
-        const auto list_val = std::static_pointer_cast<document::List>(list_it->second);
+        const auto list_val = std::static_pointer_cast<document::List>(list_it->value);
         if (list_val->value.empty()) {
             WriteNull(r, d);
             return;
@@ -120,16 +144,35 @@ std::shared_ptr<std::string> FieldWriter::GetChunkPath() const {
     return chunk_path_;
 }
 
-void FieldWriter::FlushAll() {
+void FieldWriter::FlushAll(Durability durability) {
+    if (IsLeaf()) {
+        if (!page_.IsEmpty()) {
+            WritePage();
+        }
+        if (stream == nullptr) {
+            return;
+        }
+        stream->Sync(durability);
+        return;
+    }
+    for (const auto& child : children_) {
+        std::static_pointer_cast<FieldWriter>(child)->FlushAll(durability);
+    }
+}
+
+void FieldWriter::CloseAll(Durability durability) {
     if (IsLeaf()) {
+        if (!page_.IsEmpty()) {
+            WritePage();
+        }
         if (stream == nullptr) {
             return;
         }
-        // stream->Flush();
+        stream->Close(durability);
         return;
     }
     for (const auto& child : children_) {
-        std::static_pointer_cast<FieldWriter>(child)->FlushAll();
+        std::static_pointer_cast<FieldWriter>(child)->CloseAll(durability);
     }
 }
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <lib/chunk_impl/dremel/field_descriptor.h>
+#include <lib/chunk_impl/dremel/page.h>
 #include <lib/chunk_impl/io.h>
 #include <lib/document/document.h>
 
@@ -10,8 +11,12 @@ class FieldWriter: public FieldDescriptor {
 private:
     std::shared_ptr<std::string> chunk_path_;
     std::shared_ptr<OStream> stream;
+    std::uint64_t values_count_ = 0;
+    PageWriter page_;
+    bool magic_written_ = false;
 
     std::shared_ptr<OStream> GetOrCreateStream();
+    void WritePage();
 
     void WriteNull(RepetitionLevel r, DefinitionLevel d);
     void WritePrimitiveImpl(RepetitionLevel r, DefinitionLevel d, const std::shared_ptr<document::Value>& value);
@@ -31,11 +36,22 @@ public:
         FieldLabel field_label,
         FieldType field_type,
         RepetitionLevel max_repetition_level,
-        DefinitionLevel definition_level);
+        DefinitionLevel definition_level,
+        PhysicalType physical_type = PhysicalType::Tagged);
 
     std::shared_ptr<std::string> GetChunkPath() const;
+    std::string GetFilePath() const;
+    // Replaces the stream opened on first write, see GetOrCreateStream. The
+    // column starts anew in leaf_stream, e.g. for the next row group.
+    void SetStream(const std::shared_ptr<OStream>& leaf_stream);
+    // See PageWriter::SetSplitFloatBytes.
+    void SetSplitFloatBytes(bool split_float_bytes);
+    // Values and nulls written to the current stream.
+    std::uint64_t GetValuesCount() const;
     void Write(const std::shared_ptr<document::Document>& value);
-    void FlushAll();
+    void FlushAll(Durability durability);
+    // Like FlushAll, but closes leaf streams, nothing is written after.
+    void CloseAll(Durability durability);
 };
 
 using FieldWriterPtr = std::shared_ptr<FieldWriter>;
@@ -0,0 +1,706 @@
+#include "page.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+
+#include <lib/chunk_impl/common.h>
+#include <lib/chunk_impl/dremel/encoding.h>
+
+namespace lib::chunk_impl::dremel {
+
+struct PlainType {
+    PlainValueType code;
+    PhysicalType physical_type;
+    bool (*accepts)(const document::Value& value);
+    void (*put)(std::string& out, const document::Value& value);
+    PageReader::ValueDecoder decoder;
+};
+
+namespace {
+
+    void Put4Bytes(std::string& out, std::uint32_t value) {
+        for (int i = 0; i < 4; ++i) {
+            out.push_back(static_cast<char>(value >> (8 * i)));
+        }
+    }
+
+    void Put8Bytes(std::string& out, std::uint64_t value) {
+        for (int i = 0; i < 8; ++i) {
+            out.push_back(static_cast<char>(value >> (8 * i)));
+        }
+    }
+
+    std::shared_ptr<document::Value> DecodeTagged(SpanCursor& values, const document::ArenaPtr& arena, bool borrow_strings) {
+        const auto cch = ReadControlChar(values);
+        if (!cch.has_value()) {
+            throw std::runtime_error("Unexpected end of page");
+        }
+        return ReadPrimitiveValue(*cch, values, arena, borrow_strings);
+    }
+
+    std::shared_ptr<document::Value> DecodeBoolean(SpanCursor& values, const document::ArenaPtr& arena, bool) {
+        char ch;
+        values.Get(ch);
+        return std::static_pointer_cast<document::Value>(document::MakeValue<document::Boolean>(arena, static_cast<bool>(ch)));
+    }
+
+    template <typename T, typename Raw>
+    std::shared_ptr<document::Value> DecodeFixed(SpanCursor& values, const document::ArenaPtr& arena, bool) {
+        using ValueType = decltype(T::value);
+        const auto bytes = values.ReadView(sizeof(Raw));
+        const Raw raw = sizeof(Raw) == 4 ? Load4Bytes(bytes.data()) : Load8Bytes(bytes.data());
+        ValueType value;
+        if constexpr (std::is_floating_point_v<ValueType>) {
+            std::memcpy(&value, &raw, sizeof(value));
+        } else {
+            value = static_cast<ValueType>(raw);
+        }
+        return std::static_pointer_cast<document::Value>(document::MakeValue<T>(arena, value));
+    }
+
+    std::shared_ptr<document::Value> MakeString(std::string_view value, const document::ArenaPtr& arena, bool borrow_strings) {
+        if (borrow_strings) {
+            return std::static_pointer_cast<document::Value>(document::MakeValue<document::String>(arena, value, document::kBorrowed));
+        }
+        return std::static_pointer_cast<document::Value>(document::MakeValue<document::String>(arena, value, document::GetResource(arena)));
+    }
+
+    std::shared_ptr<document::Value> DecodeString(SpanCursor& values, const document::ArenaPtr& arena, bool borrow_strings) {
+        return MakeString(ReadStringView(values), arena, borrow_strings);
+    }
+
+    // Type JSON parsing gives to an integer, see JsonHandler.
+    document::TypeId CanonicalIntegerType(std::int64_t value) {
+        if (value < 0) {
+            return value >= std::numeric_limits<std::int32_t>::min() ? document::TypeId::kInt32 : document::TypeId::kInt64;
+        }
+        return value <= std::numeric_limits<std::uint32_t>::max() ? document::TypeId::kUint32 : document::TypeId::kUint64;
+    }
+
+    std::optional<std::int64_t> GetInteger(const document::Value& value) {
+        switch (value.GetTypeId()) {
+            case document::TypeId::kInt32:
+                return static_cast<const document::Int32&>(value).value;
+            case document::TypeId::kUint32:
+                return static_cast<const document::UInt32&>(value).value;
+            case document::TypeId::kInt64:
+                return static_cast<const document::Int64&>(value).value;
+            case document::TypeId::kUint64: {
+                const auto integer = static_cast<const document::UInt64&>(value).value;
+                if (integer > static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max())) {
+                    return std::nullopt;
+                }
+                return static_cast<std::int64_t>(integer);
+            }
+            default:
+                return std::nullopt;
+        }
+    }
+
+    std::shared_ptr<document::Value> MakeInteger(std::int64_t value, const document::ArenaPtr& arena) {
+        switch (CanonicalIntegerType(value)) {
+            case document::TypeId::kInt32:
+                return std::static_pointer_cast<document::Value>(document::MakeValue<document::Int32>(arena, value));
+            case document::TypeId::kUint32:
+                return std::static_pointer_cast<document::Value>(document::MakeValue<document::UInt32>(arena, value));
+            case document::TypeId::kInt64:
+                return std::static_pointer_cast<document::Value>(document::MakeValue<document::Int64>(arena, value));
+            default:
+                return std::static_pointer_cast<document::Value>(document::MakeValue<document::UInt64>(arena, value));
+        }
+    }
+
+    template <typename Stored>
+    std::int64_t LoadInteger(const char* bytes) {
+        return static_cast<Stored>(sizeof(Stored) == 4 ? Load4Bytes(bytes) : Load8Bytes(bytes));
+    }
+
+    template <typename Stored>
+    std::shared_ptr<document::Value> DecodeInteger(SpanCursor& values, const document::ArenaPtr& arena, bool) {
+        return MakeInteger(LoadInteger<Stored>(values.ReadView(sizeof(Stored)).data()), arena);
+    }
+
+    // Same bytes as SerializePrimitiveValue after the control char.
+    void PutTaggedPayload(std::string& out, const document::Value& value) {
+        switch (value.GetTypeId()) {
+            case document::TypeId::kNull:
+                return;
+            case document::TypeId::kBoolean:
+                out.push_back(static_cast<char>(static_cast<const document::Boolean&>(value).value));
+                return;
+            case document::TypeId::kInt32:
+                Put4Bytes(out, static_cast<std::uint32_t>(static_cast<const document::Int32&>(value).value));
+                return;
+            case document::TypeId::kUint32:
+                Put4Bytes(out, static_cast<const document::UInt32&>(value).value);
+                return;
+            case document::TypeId::kInt64:
+                Put8Bytes(out, static_cast<std::uint64_t>(static_cast<const document::Int64&>(value).value));
+                return;
+            case document::TypeId::kUint64:
+                Put8Bytes(out, static_cast<const document::UInt64&>(value).value);
+                return;
+            case document::TypeId::kFloat32: {
+                std::uint32_t bits;
+                std::memcpy(&bits, &static_cast<const document::Float32&>(value).value, sizeof(bits));
+                Put4Bytes(out, bits);
+                return;
+            }
+            case document::TypeId::kFloat64: {
+                std::uint64_t bits;
+                std::memcpy(&bits, &static_cast<const document::Float64&>(value).value, sizeof(bits));
+                Put8Bytes(out, bits);
+                return;
+            }
+            case document::TypeId::kString: {
+                const auto& string = static_cast<const document::String&>(value).value;
+                Put4Bytes(out, string.size());
+                out.append(string);
+                return;
+            }
+            default:
+                throw std::runtime_error("Not primitive value");
+        }
+    }
+
+    ControlChar GetControlChar(document::TypeId type) {
+        switch (type) {
+            case document::TypeId::kNull:
+                return ControlChar::kNullFlag;
+            case document::TypeId::kBoolean:
+                return ControlChar::kBooleanFlag;
+            case document::TypeId::kInt32:
+                return ControlChar::kInt32Flag;
+            case document::TypeId::kUint32:
+                return ControlChar::kUint32Flag;
+            case document::TypeId::kInt64:
+                return ControlChar::kInt64Flag;
+            case document::TypeId::kUint64:
+                return ControlChar::kUint64Flag;
+            case document::TypeId::kFloat32:
+                return ControlChar::kFloat32Flag;
+            case document::TypeId::kFloat64:
+                return ControlChar::kFloat64Flag;
+            case document::TypeId::kString:
+                return ControlChar::kStringFlag;
+            default:
+                throw std::runtime_error("Not primitive value");
+        }
+    }
+
+    template <typename Stored>
+    bool AcceptsInteger(const document::Value& value) {
+        const auto integer = GetInteger(value);
+        return integer.has_value() && CanonicalIntegerType(*integer) == value.GetTypeId() &&
+               *integer >= std::numeric_limits<Stored>::min() && *integer <= std::numeric_limits<Stored>::max();
+    }
+
+    template <typename Stored>
+    void PutInteger(std::string& out, const document::Value& value) {
+        if constexpr (sizeof(Stored) == 4) {
+            Put4Bytes(out, static_cast<std::uint32_t>(*GetInteger(value)));
+        } else {
+            Put8Bytes(out, static_cast<std::uint64_t>(*GetInteger(value)));
+        }
+    }
+
+    // Float32 is what JSON parsing gives to numbers up to the max float.
+    bool AcceptsFloat(const document::Value& value) {
+        switch (value.GetTypeId()) {
+            case document::TypeId::kFloat32:
+                return std::isfinite(static_cast<const document::Float32&>(value).value);
+            case document::TypeId::kFloat64:
+                return !(std::abs(static_cast<const document::Float64&>(value).value) <= std::numeric_limits<float>::max());
+            default:
+                return false;
+        }
+    }
+
+    void PutFloat(std::string& out, const document::Value& value) {
+        const double floating = value.GetTypeId() == document::TypeId::kFloat32 ? static_cast<const document::Float32&>(value).value : static_cast<const document::Float64&>(value).value;
+        std::uint64_t bits;
+        std::memcpy(&bits, &floating, sizeof(bits));
+        Put8Bytes(out, bits);
+    }
+
+    std::shared_ptr<document::Value> DecodeFloat(SpanCursor& values, const document::ArenaPtr& arena, bool) {
+        const auto bits = Load8Bytes(values.ReadView(8).data());
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        if (std::abs(value) <= std::numeric_limits<float>::max()) {
+            return std::static_pointer_cast<document::Value>(document::MakeValue<document::Float32>(arena, static_cast<float>(value)));
+        }
+        return std::static_pointer_cast<document::Value>(document::MakeValue<document::Float64>(arena, value));
+    }
+
+    template <document::TypeId kType>
+    bool AcceptsType(const document::Value& value) {
+        return value.GetTypeId() == kType;
+    }
+
+    const PlainType kPlainTypes[] = {
+        {PlainValueType::Boolean, PhysicalType::Bool, AcceptsType<document::TypeId::kBoolean>, PutTaggedPayload, DecodeBoolean},
+        {PlainValueType::Integer32, PhysicalType::Int, AcceptsInteger<std::int32_t>, PutInteger<std::int32_t>, DecodeInteger<std::int32_t>},
+        {PlainValueType::Integer, PhysicalType::Int, AcceptsInteger<std::int64_t>, PutInteger<std::int64_t>, DecodeInteger<std::int64_t>},
+        {PlainValueType::Float32, PhysicalType::Double, AcceptsType<document::TypeId::kFloat32>, PutTaggedPayload, DecodeFixed<document::Float32, std::uint32_t>},
+        {PlainValueType::Float64, PhysicalType::Double, AcceptsType<document::TypeId::kFloat64>, PutTaggedPayload, DecodeFixed<document::Float64, std::uint64_t>},
+        {PlainValueType::Float, PhysicalType::Double, AcceptsFloat, PutFloat, DecodeFloat},
+        {PlainValueType::String, PhysicalType::String, AcceptsType<document::TypeId::kString>, PutTaggedPayload, DecodeString},
+    };
+
+    const PlainType* FindPlainType(PhysicalType physical_type, const document::Value& value) {
+        for (const auto& plain_type : kPlainTypes) {
+            if (plain_type.physical_type == physical_type && plain_type.accepts(value)) {
+                return &plain_type;
+            }
+        }
+        return nullptr;
+    }
+
+    const PlainType* FindPlainType(PlainValueType code) {
+        for (const auto& plain_type : kPlainTypes) {
+            if (plain_type.code == code) {
+                return &plain_type;
+            }
+        }
+        return nullptr;
+    }
+
+    void PutTaggedValue(std::string& out, const document::Value& value) {
+        out.push_back(static_cast<char>(GetControlChar(value.GetTypeId())));
+        PutTaggedPayload(out, value);
+    }
+
+    // Re-encodes plain values as values of to, or tagged ones when to is
+    // nullptr. Fails if to does not accept some of them.
+    bool ConvertValues(std::string& values, const PlainType& from, const PlainType* to) {
+        std::string converted;
+        converted.reserve(values.size() * 2);
+        SpanCursor cursor(values.data(), values.data() + values.size());
+        while (!cursor.Eof()) {
+            const auto value = from.decoder(cursor, nullptr, false);
+            if (to == nullptr) {
+                PutTaggedValue(converted, *value);
+            } else if (to->accepts(*value)) {
+                to->put(converted, *value);
+            } else {
+                return false;
+            }
+        }
+        values = std::move(converted);
+        return true;
+    }
+
+    // Re-encodes plain values as values of a type that also accepts value, or
+    // tagged ones if there is none. Returns the type, nullptr for tagged.
+    const PlainType* WidenValues(std::string& values, const PlainType& from, PhysicalType physical_type, const document::Value& value) {
+        for (const auto& plain_type : kPlainTypes) {
+            if (&plain_type != &from && plain_type.physical_type == physical_type && plain_type.accepts(value) &&
+                ConvertValues(values, from, &plain_type)) {
+                return &plain_type;
+            }
+        }
+        ConvertValues(values, from, nullptr);
+        return nullptr;
+    }
+
+    bool IsIntegerEncoding(ValueEncoding encoding) {
+        return encoding == ValueEncoding::FrameOfReference || encoding == ValueEncoding::Delta || encoding == ValueEncoding::DeltaOfDelta;
+    }
+
+    bool IsFloatEncoding(ValueEncoding encoding) {
+        return encoding == ValueEncoding::ByteStreamSplit || encoding == ValueEncoding::Gorilla;
+    }
+
+    std::size_t GetFloatSize(PlainValueType code) {
+        return code == PlainValueType::Float32 ? 4 : 8;
+    }
+
+    std::vector<std::int64_t> LoadIntegers(const std::string& values, PlainValueType code) {
+        const auto size = code == PlainValueType::Integer32 ? 4 : 8;
+        std::vector<std::int64_t> integers(values.size() / size);
+        for (std::size_t i = 0; i < integers.size(); ++i) {
+            const auto* bytes = values.data() + i * size;
+            integers[i] = code == PlainValueType::Integer32 ? LoadInteger<std::int32_t>(bytes) : LoadInteger<std::int64_t>(bytes);
+        }
+        return integers;
+    }
+
+} // namespace
+
+std::size_t GetPageSize(const char* header) {
+    return kPageHeaderSize + Load4Bytes(header + 4);
+}
+
+PageWriter::PageWriter(RepetitionLevel max_repetition_level, DefinitionLevel max_definition_level, PhysicalType physical_type)
+    : max_repetition_level_(max_repetition_level)
+    , max_definition_level_(max_definition_level)
+    , physical_type_(physical_type) {
+}
+
+void PageWriter::Add(RepetitionLevel r, DefinitionLevel d, const document::Value& value) {
+    repetition_levels_.push_back(r);
+    definition_levels_.push_back(d);
+    if (d != max_definition_level_) {
+        return;
+    }
+
+    if (!tagged_ && plain_type_ == nullptr) {
+        plain_type_ = FindPlainType(physical_type_, value);
+        tagged_ = plain_type_ == nullptr;
+    } else if (!tagged_ && !plain_type_->accepts(value)) {
+        // Widened at most once or twice per page, e.g. to 8 byte integers.
+        plain_type_ = WidenValues(values_, *plain_type_, physical_type_, value);
+        tagged_ = plain_type_ == nullptr;
+    }
+
+    if (tagged_) {
+        DisableDictionary();
+        PutTaggedValue(values_, value);
+    } else {
+        plain_type_->put(values_, value);
+        if (plain_type_->code == PlainValueType::String && !dictionary_disabled_) {
+            AddToDictionary(value);
+        }
+    }
+}
+
+void PageWriter::AddToDictionary(const document::Value& value) {
+    const auto& string = static_cast<const document::String&>(value).value;
+    auto [it, inserted] = dictionary_.try_emplace(std::string(string), dictionary_entries_.size());
+    if (inserted) {
+        dictionary_entries_.push_back(&it->first);
+        dictionary_size_ += 4 + string.size();
+        if (dictionary_entries_.size() > kMaxDictionaryEntries || dictionary_size_ > kMaxDictionarySize) {
+            DisableDictionary();
+            return;
+        }
+    }
+    ids_.push_back(it->second);
+}
+
+void PageWriter::DisableDictionary() {
+    if (dictionary_disabled_) {
+        return;
+    }
+    dictionary_disabled_ = true;
+    dictionary_.clear();
+    dictionary_entries_.clear();
+    dictionary_size_ = 0;
+    ids_.clear();
+}
+
+std::optional<std::string> PageWriter::EncodeDictionary() const {
+    if (plain_type_ == nullptr || plain_type_->code != PlainValueType::String || dictionary_disabled_ ||
+        4 + dictionary_size_ >= values_.size()) {
+        return std::nullopt;
+    }
+    std::string encoded;
+    encoded.reserve(4 + dictionary_size_);
+    Put4Bytes(encoded, dictionary_entries_.size());
+    for (const auto* entry : dictionary_entries_) {
+        Put4Bytes(encoded, entry->size());
+        encoded.append(*entry);
+    }
+    EncodeRleBitPacked(ids_.data(), ids_.size(), BitWidth(dictionary_entries_.size() - 1), encoded);
+    if (encoded.size() >= values_.size()) {
+        return std::nullopt;
+    }
+    return encoded;
+}
+
+std::optional<std::pair<ValueEncoding, std::string>> PageWriter::EncodeIntegers() const {
+    if (plain_type_ == nullptr || plain_type_->physical_type != PhysicalType::Int) {
+        return std::nullopt;
+    }
+    const auto integers = LoadIntegers(values_, plain_type_->code);
+    std::optional<std::pair<ValueEncoding, std::string>> smallest;
+    const std::pair<ValueEncoding, void (*)(const std::int64_t*, std::size_t, std::string&)> encoders[] = {
+        {ValueEncoding::FrameOfReference, EncodeFrameOfReference},
+        {ValueEncoding::Delta, EncodeDelta},
+        {ValueEncoding::DeltaOfDelta, EncodeDeltaOfDelta},
+    };
+    for (const auto& [encoding, encode] : encoders) {
+        std::string encoded;
+        encode(integers.data(), integers.size(), encoded);
+        if (encoded.size() < (smallest.has_value() ? smallest->second.size() : values_.size())) {
+            smallest.emplace(encoding, std::move(encoded));
+        }
+    }
+    return smallest;
+}
+
+std::optional<std::pair<ValueEncoding, std::string>> PageWriter::EncodeFloats() const {
+    if (plain_type_ == nullptr || plain_type_->physical_type != PhysicalType::Double) {
+        return std::nullopt;
+    }
+    const auto value_size = GetFloatSize(plain_type_->code);
+    const auto count = values_.size() / value_size;
+    std::string encoded;
+    EncodeGorilla(values_.data(), count, value_size, encoded);
+    if (encoded.size() < values_.size()) {
+        return std::make_pair(ValueEncoding::Gorilla, std::move(encoded));
+    }
+    if (split_float_bytes_) {
+        encoded.clear();
+        EncodeByteStreamSplit(values_.data(), count, value_size, encoded);
+        return std::make_pair(ValueEncoding::ByteStreamSplit, std::move(encoded));
+    }
+    return std::nullopt;
+}
+
+std::optional<std::string> PageWriter::EncodeBooleans() const {
+    if (plain_type_ == nullptr || plain_type_->code != PlainValueType::Boolean || values_.size() < 2) {
+        return std::nullopt;
+    }
+    std::string encoded;
+    EncodeBitmap(values_.data(), values_.size(), encoded);
+    return encoded;
+}
+
+void PageWriter::SetSplitFloatBytes(bool split_float_bytes) {
+    split_float_bytes_ = split_float_bytes;
+}
+
+bool PageWriter::IsEmpty() const {
+    return repetition_levels_.empty();
+}
+
+bool PageWriter::IsFull() const {
+    return repetition_levels_.size() >= kMaxRows || values_.size() >= kMaxValuesSize;
+}
+
+void PageWriter::WriteTo(OStream& stream) {
+    std::string repetition_levels;
+    std::string definition_levels;
+    EncodeRleBitPacked(repetition_levels_.data(), repetition_levels_.size(), BitWidth(max_repetition_level_), repetition_levels);
+    EncodeRleBitPacked(definition_levels_.data(), definition_levels_.size(), BitWidth(max_definition_level_), definition_levels);
+    std::uint8_t flags = 0;
+    if (max_repetition_level_ == 0 && max_definition_level_ == 1) {
+        // Preferred on ties, counting values of a bitmap is cheaper.
+        std::string validity;
+        EncodeBitmap(definition_levels_.data(), definition_levels_.size(), validity);
+        if (validity.size() <= definition_levels.size()) {
+            definition_levels = std::move(validity);
+            flags |= kValidityBitmapFlag;
+        }
+    }
+
+    auto encoding = plain_type_ != nullptr ? ValueEncoding::Plain : ValueEncoding::Tagged;
+    const auto value_type = plain_type_ != nullptr ? static_cast<char>(plain_type_->code) : 0;
+    if (auto dictionary = EncodeDictionary()) {
+        encoding = ValueEncoding::Dictionary;
+        values_ = std::move(*dictionary);
+    } else if (auto integers = EncodeIntegers()) {
+        encoding = integers->first;
+        values_ = std::move(integers->second);
+    } else if (auto floats = EncodeFloats()) {
+        encoding = floats->first;
+        values_ = std::move(floats->second);
+    } else if (auto booleans = EncodeBooleans()) {
+        encoding = ValueEncoding::BitPacked;
+        values_ = std::move(*booleans);
+    }
+
+    std::string header;
+    Put4Bytes(header, repetition_levels_.size());
+    Put4Bytes(header, 10 + repetition_levels.size() + definition_levels.size() + values_.size());
+    header.push_back(static_cast<char>(static_cast<std::uint8_t>(encoding) | flags));
+    header.push_back(value_type);
+    Put4Bytes(header, repetition_levels.size());
+    Put4Bytes(header, definition_levels.size());
+    stream.Write(header.data(), header.size());
+    stream.Write(repetition_levels.data(), repetition_levels.size());
+    stream.Write(definition_levels.data(), definition_levels.size());
+    stream.Write(values_.data(), values_.size());
+
+    repetition_levels_.clear();
+    definition_levels_.clear();
+    plain_type_ = nullptr;
+    tagged_ = false;
+    values_.clear();
+    dictionary_disabled_ = false;
+    dictionary_.clear();
+    dictionary_entries_.clear();
+    dictionary_size_ = 0;
+    ids_.clear();
+}
+
+PageReader::PageReader(RepetitionLevel max_repetition_level, DefinitionLevel max_definition_level, PhysicalType physical_type)
+    : max_repetition_level_(max_repetition_level)
+    , max_definition_level_(max_definition_level)
+    , physical_type_(physical_type) {
+}
+
+void PageReader::Load(SpanCursor& input) {
+    rows_ = Read4Bytes(input);
+    auto body = input.ReadView(Read4Bytes(input));
+    SpanCursor body_cursor(body.data(), body.data() + body.size());
+    char encoding;
+    char value_type;
+    body_cursor.Get(encoding);
+    body_cursor.Get(value_type);
+    const auto repetition_levels_size = Read4Bytes(body_cursor);
+    const auto definition_levels_size = Read4Bytes(body_cursor);
+    const auto repetition_levels = body_cursor.ReadView(repetition_levels_size);
+    const auto definition_levels = body_cursor.ReadView(definition_levels_size);
+
+    const bool validity_bitmap = static_cast<std::uint8_t>(encoding) & kValidityBitmapFlag;
+    if (validity_bitmap && (max_repetition_level_ != 0 || max_definition_level_ != 1)) {
+        throw std::runtime_error("Validity bitmap of a nested leaf");
+    }
+    encoding_ = static_cast<ValueEncoding>(static_cast<std::uint8_t>(encoding) & ~kValidityBitmapFlag);
+    switch (encoding_) {
+        case ValueEncoding::Tagged:
+            decoder_ = DecodeTagged;
+            break;
+        case ValueEncoding::Plain:
+        case ValueEncoding::Dictionary:
+        case ValueEncoding::FrameOfReference:
+        case ValueEncoding::Delta:
+        case ValueEncoding::DeltaOfDelta:
+        case ValueEncoding::ByteStreamSplit:
+        case ValueEncoding::Gorilla:
+        case ValueEncoding::BitPacked: {
+            const auto plain_type = FindPlainType(static_cast<PlainValueType>(value_type));
+            if (plain_type == nullptr) {
+                throw std::runtime_error("Unknown page value type");
+            }
+            if (physical_type_ != PhysicalType::Tagged && plain_type->physical_type != physical_type_) {
+                throw std::runtime_error("Page value type does not match schema");
+            }
+            if ((encoding_ == ValueEncoding::Dictionary && plain_type->code != PlainValueType::String) ||
+                (IsIntegerEncoding(encoding_) && plain_type->physical_type != PhysicalType::Int) ||
+                (IsFloatEncoding(encoding_) && plain_type->physical_type != PhysicalType::Double) ||
+                (encoding_ == ValueEncoding::BitPacked && plain_type->code != PlainValueType::Boolean)) {
+                throw std::runtime_error("Page encoding does not match value type");
+            }
+            decoder_ = plain_type->decoder;
+            break;
+        }
+        default:
+            throw std::runtime_error("Unknown page encoding");
+    }
+
+    repetition_levels_.resize(rows_);
+    definition_levels_.resize(rows_);
+    SpanCursor repetition_levels_cursor(repetition_levels.data(), repetition_levels.data() + repetition_levels.size());
+    DecodeRleBitPacked(repetition_levels_cursor, BitWidth(max_repetition_level_), rows_, repetition_levels_.data());
+    if (validity_bitmap) {
+        ExpandBitmap(definition_levels, rows_, definition_levels_.data());
+        values_count_ = CountBits(definition_levels, rows_);
+    } else {
+        SpanCursor definition_levels_cursor(definition_levels.data(), definition_levels.data() + definition_levels.size());
+        DecodeRleBitPacked(definition_levels_cursor, BitWidth(max_definition_level_), rows_, definition_levels_.data());
+        values_count_ = std::count(definition_levels_.begin(), definition_levels_.end(), max_definition_level_);
+    }
+
+    index_ = 0;
+    const auto values = body_cursor.ReadView(body.size() - body_cursor.Tellg());
+    values_ = SpanCursor(values.data(), values.data() + values.size());
+    if (encoding_ == ValueEncoding::Dictionary) {
+        LoadDictionary();
+    } else if (IsIntegerEncoding(encoding_)) {
+        LoadIntegers();
+    } else if (IsFloatEncoding(encoding_)) {
+        LoadFloats(GetFloatSize(static_cast<PlainValueType>(value_type)));
+    } else if (encoding_ == ValueEncoding::BitPacked) {
+        LoadBooleans();
+    }
+}
+
+void PageReader::LoadDictionary() {
+    dictionary_.resize(Read4Bytes(values_));
+    for (auto& entry : dictionary_) {
+        entry = ReadStringView(values_);
+    }
+    ids_.resize(values_count_);
+    DecodeRleBitPacked(values_, BitWidth(dictionary_.empty() ? 0 : dictionary_.size() - 1), ids_.size(), ids_.data());
+    if (std::any_of(ids_.begin(), ids_.end(), [this](auto id) { return id >= dictionary_.size(); })) {
+        throw std::runtime_error("Dictionary id out of range");
+    }
+    next_id_ = 0;
+}
+
+void PageReader::LoadIntegers() {
+    integers_.resize(values_count_);
+    switch (encoding_) {
+        case ValueEncoding::FrameOfReference:
+            DecodeFrameOfReference(values_, integers_.size(), integers_.data());
+            break;
+        case ValueEncoding::Delta:
+            DecodeDelta(values_, integers_.size(), integers_.data());
+            break;
+        default:
+            DecodeDeltaOfDelta(values_, integers_.size(), integers_.data());
+            break;
+    }
+    next_integer_ = 0;
+}
+
+void PageReader::LoadFloats(std::size_t value_size) {
+    const auto count = values_count_;
+    decoded_values_.resize(count * value_size);
+    if (encoding_ == ValueEncoding::Gorilla) {
+        DecodeGorilla(values_, count, value_size, decoded_values_.data());
+    } else {
+        DecodeByteStreamSplit(values_, count, value_size, decoded_values_.data());
+    }
+    // Read by the plain decoder.
+    values_ = SpanCursor(decoded_values_.data(), decoded_values_.data() + decoded_values_.size());
+}
+
+void PageReader::LoadBooleans() {
+    decoded_values_.resize(values_count_);
+    ExpandBitmap(values_.ReadView((values_count_ + 7) / 8), values_count_, decoded_values_.data());
+    values_ = SpanCursor(decoded_values_.data(), decoded_values_.data() + decoded_values_.size());
+}
+
+bool PageReader::HasRows() const {
+    return index_ < rows_;
+}
+
+RepetitionLevel PageReader::PeekRepetitionLevel() const {
+    return repetition_levels_[index_];
+}
+
+bool PageReader::Next(RepetitionLevel& r, DefinitionLevel& d) {
+    if (index_ >= rows_) {
+        throw std::out_of_range("Read past the end of page");
+    }
+    r = repetition_levels_[index_];
+    d = definition_levels_[index_];
+    ++index_;
+    return d == max_definition_level_;
+}
+
+std::shared_ptr<document::Value> PageReader::ReadValue(const document::ArenaPtr& arena, bool borrow_strings) {
+    if (encoding_ == ValueEncoding::Dictionary) {
+        return MakeString(dictionary_[ReadDictionaryId()], arena, borrow_strings);
+    }
+    if (IsIntegerEncoding(encoding_)) {
+        if (next_integer_ >= integers_.size()) {
+            throw std::out_of_range("Read past the end of page values");
+        }
+        return MakeInteger(integers_[next_integer_++], arena);
+    }
+    return decoder_(values_, arena, borrow_strings);
+}
+
+const std::vector<std::string_view>* PageReader::GetDictionary() const {
+    return encoding_ == ValueEncoding::Dictionary ? &dictionary_ : nullptr;
+}
+
+std::uint32_t PageReader::ReadDictionaryId() {
+    if (encoding_ != ValueEncoding::Dictionary || next_id_ >= ids_.size()) {
+        throw std::out_of_range("Read past the end of dictionary ids");
+    }
+    return ids_[next_id_++];
+}
+
+} // namespace lib::chunk_impl::dremel
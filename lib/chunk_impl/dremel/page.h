@@ -0,0 +1,188 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <lib/chunk_impl/dremel/field_descriptor.h>
+#include <lib/chunk_impl/io.h>
+#include <lib/document/arena.h>
+#include <lib/document/document.h>
+
+namespace lib::chunk_impl::dremel {
+
+// Leaf columns starting with the magic are sequences of pages:
+//   page := rows (4 bytes) | body size (4 bytes) | body
+//   body := encoding (1 byte) | value type (1 byte) | r size (4 bytes) |
+//           d size (4 bytes) | r levels | d levels | values
+// Levels are encoded with EncodeRleBitPacked at the width of the max level of
+// the leaf. For optional leaves outside lists (max r 0, max d 1), d levels may
+// be a validity bitmap instead, see kValidityBitmapFlag. Values are stored
+// only for rows at the max definition level.
+// Values of dictionary pages are
+//   entries count (4 bytes) | entries | ids
+// with entries in the String format and ids of values encoded with
+// EncodeRleBitPacked at the width of the max id. Values of integer,
+// floating-point and bit-packed encodings are decoded for the whole page on
+// load.
+// Columns without the magic are in the row format:
+//   r (4 bytes) | d (2 bytes) | control char | value.
+constexpr std::string_view kPagedColumnMagic = "DRPG";
+constexpr std::size_t kPageHeaderSize = 8;
+// Set in the encoding byte when d levels are stored with EncodeBitmap.
+constexpr std::uint8_t kValidityBitmapFlag = 0x80;
+
+enum class ValueEncoding : std::uint8_t {
+    // Control char followed by the value, as in the row format.
+    Tagged = 0,
+    // Values of the single value type of the page without control chars.
+    Plain = 1,
+    // Distinct values of the page followed by ids of values, String only.
+    Dictionary = 2,
+    // Integer encodings of values of Integer32 and Integer types, see
+    // EncodeFrameOfReference, EncodeDelta and EncodeDeltaOfDelta.
+    FrameOfReference = 3,
+    Delta = 4,
+    DeltaOfDelta = 5,
+    // Encodings of values of Float32 and Float64 types, see
+    // EncodeByteStreamSplit and EncodeGorilla.
+    ByteStreamSplit = 6,
+    Gorilla = 7,
+    // Boolean values one bit each, see EncodeBitmap.
+    BitPacked = 8,
+};
+
+// Value types of plain pages, each belongs to one PhysicalType.
+enum class PlainValueType : char {
+    // 1 byte.
+    Boolean = 'b',
+    // 4 and 8 bytes little-endian. Decoded into the type JSON parsing gives
+    // the number, values of other integer types make the page tagged. Pages
+    // are widened to Integer when a value does not fit Integer32.
+    Integer32 = 'M',
+    Integer = 'N',
+    // Little-endian IEEE 754. Pages of Float32 and Float64 are widened to
+    // Float, 8 bytes decoded into the type JSON parsing gives the number.
+    Float32 = 'f',
+    Float64 = 'd',
+    Float = 'F',
+    // Length (4 bytes) followed by the bytes.
+    String = 's',
+};
+
+struct PlainType;
+
+// Size of the page including its header.
+std::size_t GetPageSize(const char* header);
+
+class PageWriter {
+public:
+    // A page is written when either limit is reached.
+    static constexpr std::size_t kMaxRows = 8192;
+    static constexpr std::size_t kMaxValuesSize = 1 << 20;
+    // Pages with larger dictionaries are plain.
+    static constexpr std::size_t kMaxDictionaryEntries = 1 << 14;
+    static constexpr std::size_t kMaxDictionarySize = 1 << 18;
+
+    PageWriter(RepetitionLevel max_repetition_level, DefinitionLevel max_definition_level, PhysicalType physical_type);
+
+    // value is ignored below the max definition level. Pages are plain while
+    // all values fit a plain type of physical_type, and switch to tagged on
+    // the first value that does not (e.g. a null list element). String pages
+    // are written with a dictionary and integer pages with the smallest
+    // integer encoding when it is smaller than plain values. Floating-point
+    // pages are written with Gorilla encoding when it is smaller, boolean
+    // pages are bit-packed.
+    void Add(RepetitionLevel r, DefinitionLevel d, const document::Value& value);
+    bool IsEmpty() const;
+    bool IsFull() const;
+    // Writes the page and starts a new one.
+    void WriteTo(OStream& stream);
+    // Floating-point pages not shrunk by Gorilla encoding are byte stream
+    // split, for chunks compressed afterwards.
+    void SetSplitFloatBytes(bool split_float_bytes);
+
+private:
+    RepetitionLevel max_repetition_level_;
+    DefinitionLevel max_definition_level_;
+    PhysicalType physical_type_;
+    std::vector<std::uint32_t> repetition_levels_;
+    std::vector<std::uint32_t> definition_levels_;
+    // Unset for tagged pages and pages without values.
+    const PlainType* plain_type_ = nullptr;
+    bool tagged_ = false;
+    std::string values_;
+    // Built while the page has only strings and the dictionary is in limits.
+    bool dictionary_disabled_ = false;
+    std::unordered_map<std::string, std::uint32_t> dictionary_;
+    std::vector<const std::string*> dictionary_entries_;
+    std::size_t dictionary_size_ = 0;
+    std::vector<std::uint32_t> ids_;
+    bool split_float_bytes_ = false;
+
+    void AddToDictionary(const document::Value& value);
+    void DisableDictionary();
+    // Dictionary encoded values if they are smaller than plain ones.
+    std::optional<std::string> EncodeDictionary() const;
+    std::optional<std::pair<ValueEncoding, std::string>> EncodeIntegers() const;
+    std::optional<std::pair<ValueEncoding, std::string>> EncodeFloats() const;
+    std::optional<std::string> EncodeBooleans() const;
+};
+
+class PageReader {
+public:
+    using ValueDecoder = std::shared_ptr<document::Value> (*)(SpanCursor& values, const document::ArenaPtr& arena, bool borrow_strings);
+
+    // Plain pages must have values of physical_type, unless it is Tagged.
+    PageReader(RepetitionLevel max_repetition_level, DefinitionLevel max_definition_level, PhysicalType physical_type);
+
+    // Decodes levels of the page at input and skips it, values are decoded
+    // from input memory row by row.
+    void Load(SpanCursor& input);
+    bool HasRows() const;
+    RepetitionLevel PeekRepetitionLevel() const;
+    // Returns whether the row has a value, which is read by ReadValue next.
+    bool Next(RepetitionLevel& r, DefinitionLevel& d);
+    // With borrow_strings, strings reference input memory.
+    std::shared_ptr<document::Value> ReadValue(const document::ArenaPtr& arena, bool borrow_strings);
+    // Distinct values of a dictionary page, nullptr for other pages. Entries
+    // reference input memory and are valid until the next Load.
+    const std::vector<std::string_view>* GetDictionary() const;
+    // Instead of ReadValue on dictionary pages, skips the value and returns
+    // its index in GetDictionary().
+    std::uint32_t ReadDictionaryId();
+
+private:
+    RepetitionLevel max_repetition_level_;
+    DefinitionLevel max_definition_level_;
+    PhysicalType physical_type_;
+    std::vector<std::uint32_t> repetition_levels_;
+    std::vector<std::uint32_t> definition_levels_;
+    std::size_t rows_ = 0;
+    std::size_t index_ = 0;
+    SpanCursor values_{nullptr, nullptr};
+    // Specialized for the value type of plain pages.
+    ValueDecoder decoder_ = nullptr;
+    ValueEncoding encoding_ = ValueEncoding::Tagged;
+    std::vector<std::string_view> dictionary_;
+    std::vector<std::uint32_t> ids_;
+    std::size_t next_id_ = 0;
+    std::vector<std::int64_t> integers_;
+    std::size_t next_integer_ = 0;
+    // Rows at the max definition level.
+    std::size_t values_count_ = 0;
+    // Plain values decoded from floating-point and bit-packed encodings.
+    std::vector<char> decoded_values_;
+
+    void LoadDictionary();
+    void LoadIntegers();
+    void LoadFloats(std::size_t value_size);
+    void LoadBooleans();
+};
+
+} // namespace lib::chunk_impl::dremel
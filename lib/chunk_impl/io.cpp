@@ -1,17 +1,132 @@
 #include "io.h"
 
 #include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <cstdlib>
 #include <cstring>
 #include <fcntl.h>
 #include <iostream>
+#include <new>
 #include <stdexcept>
 #include <string>
 #include <unistd.h>
 
+#include <lib/chunk_impl/thread_pool.h>
+
 namespace lib::chunk_impl {
 
-MmapFileReader::MmapFileReader(const char* filename)
-    : current_pos_(0) {
+namespace {
+
+    constexpr std::size_t kCopyBlockSize = 1 << 20;
+    // Mappings this large are backed by transparent huge pages where the
+    // kernel supports them for files, fewer TLB misses and page faults.
+    constexpr std::size_t kHugePagesThreshold = 256 << 20;
+
+    void WriteAll(int fd, const char* buffer, std::size_t length) {
+        while (length > 0) {
+            const auto written = write(fd, buffer, length);
+            if (written == -1 && errno == EINTR) {
+                continue;
+            }
+            if (written == -1) {
+                throw std::runtime_error(std::string("Failed to write output: ") + strerror(errno));
+            }
+            buffer += written;
+            length -= written;
+        }
+    }
+
+    bool IsPipe(int fd) {
+        struct stat st;
+        return fstat(fd, &st) == 0 && S_ISFIFO(st.st_mode);
+    }
+
+    void PWriteAll(int fd, const char* buffer, std::size_t length, std::size_t offset) {
+        while (length > 0) {
+            const auto written = pwrite(fd, buffer, length, offset);
+            if (written == -1 && errno == EINTR) {
+                continue;
+            }
+            if (written == -1) {
+                throw std::runtime_error(std::string("Failed to write file: ") + strerror(errno));
+            }
+            buffer += written;
+            length -= written;
+            offset += written;
+        }
+    }
+
+    void SyncFile(int fd, Durability durability) {
+        int res = 0;
+        if (durability == Durability::Async) {
+            res = sync_file_range(fd, 0, 0, SYNC_FILE_RANGE_WRITE);
+        } else if (durability == Durability::Full) {
+            res = fdatasync(fd);
+        }
+        if (res == -1) {
+            throw std::runtime_error(std::string("Failed to sync file: ") + strerror(errno));
+        }
+    }
+
+    // Shared by all file readers and writers, background I/O is bound by the
+    // disk rather than by the number of threads.
+    ThreadPool& BackgroundIoPool() {
+        static ThreadPool pool(2);
+        return pool;
+    }
+
+    // Closes owned descriptors, standard streams are left open.
+    class ScopedFd {
+    public:
+        ScopedFd(int fd, bool owned)
+            : fd_(fd)
+            , owned_(owned) {
+        }
+        ~ScopedFd() {
+            if (owned_ && fd_ != -1) {
+                close(fd_);
+            }
+        }
+        ScopedFd(const ScopedFd&) = delete;
+        ScopedFd& operator=(const ScopedFd&) = delete;
+
+        int Get() const {
+            return fd_;
+        }
+
+    private:
+        int fd_;
+        bool owned_;
+    };
+
+} // namespace
+
+Durability ParseDurability(const std::string& name) {
+    if (name == "none") {
+        return Durability::None;
+    } else if (name == "async") {
+        return Durability::Async;
+    } else if (name == "full") {
+        return Durability::Full;
+    } else {
+        throw std::runtime_error("Unknown durability, supported modes are [none, async, full]");
+    }
+}
+
+bool IStream::SupportsViews() const {
+    return false;
+}
+
+std::string_view IStream::ReadView(std::size_t) {
+    throw std::logic_error("Stream does not support views");
+}
+
+std::string_view IStream::ReadLineView() {
+    throw std::logic_error("Stream does not support views");
+}
+
+MmapFileReader::MmapFileReader(const char* filename) {
     fd_ = open(filename, O_RDONLY);
     if (fd_ == -1) {
         throw std::runtime_error(std::string("Failed to open input file: ") + filename + " " + strerror(errno));
@@ -29,6 +144,14 @@ MmapFileReader::MmapFileReader(const char* filename)
         close(fd_);
         throw std::runtime_error("Failed to mmap file");
     }
+
+    // Chunks are decoded front to back: read ahead aggressively and drop pages
+    // behind. Advice is a hint, failures are ignored.
+    madvise(data_, file_size_, MADV_SEQUENTIAL);
+    madvise(data_, file_size_, MADV_WILLNEED);
+    if (file_size_ >= kHugePagesThreshold) {
+        madvise(data_, file_size_, MADV_HUGEPAGE);
+    }
 }
 
 MmapFileReader::~MmapFileReader() {
@@ -40,7 +163,7 @@ MmapFileReader::~MmapFileReader() {
     }
 }
 
-void MmapFileReader::Seekg(int offset, std::ios_base::seekdir dir) {
+void MemoryReader::Seekg(int offset, std::ios_base::seekdir dir) {
     if (dir == std::ios_base::beg) {
         current_pos_ = offset;
     } else if (dir == std::ios_base::cur) {
@@ -53,22 +176,22 @@ void MmapFileReader::Seekg(int offset, std::ios_base::seekdir dir) {
     }
 }
 
-int MmapFileReader::Peek() const {
+int MemoryReader::Peek() const {
     if (current_pos_ < file_size_) {
-        return static_cast<char>(data_[current_pos_]);
+        return static_cast<unsigned char>(data_[current_pos_]);
     }
     return EOF;
 }
 
-std::size_t MmapFileReader::Tellg() const {
+std::size_t MemoryReader::Tellg() const {
     return current_pos_;
 }
 
-bool MmapFileReader::Eof() const {
+bool MemoryReader::Eof() const {
     return current_pos_ >= file_size_;
 }
 
-void MmapFileReader::Read(char* buffer, std::size_t length) {
+void MemoryReader::Read(char* buffer, std::size_t length) {
     if (current_pos_ + length > file_size_) {
         throw std::out_of_range("Read exceeds file size");
     }
@@ -76,7 +199,32 @@ void MmapFileReader::Read(char* buffer, std::size_t length) {
     current_pos_ += length;
 }
 
-void MmapFileReader::Get(char& ch) {
+bool MemoryReader::SupportsViews() const {
+    return true;
+}
+
+std::string_view MemoryReader::ReadView(std::size_t length) {
+    if (current_pos_ + length > file_size_) {
+        throw std::out_of_range("Read exceeds file size");
+    }
+    std::string_view view(data_ + current_pos_, length);
+    current_pos_ += length;
+    return view;
+}
+
+const char* MemoryReader::Data() const {
+    return data_;
+}
+
+std::size_t MemoryReader::Size() const {
+    return file_size_;
+}
+
+SpanCursor MemoryReader::GetCursor() const {
+    return SpanCursor(data_ + current_pos_, data_ + file_size_);
+}
+
+void MemoryReader::Get(char& ch) {
     if (current_pos_ < file_size_) {
         ch = data_[current_pos_++];
     } else {
@@ -84,136 +232,570 @@ void MmapFileReader::Get(char& ch) {
     }
 }
 
-std::string MmapFileReader::ReadLine() {
-    std::string line;
-    while (current_pos_ < file_size_ && data_[current_pos_] != '\n') {
-        line += data_[current_pos_++];
+std::string MemoryReader::ReadLine() {
+    return std::string(ReadLineView());
+}
+
+std::string_view MemoryReader::ReadLineView() {
+    const auto begin = data_ + current_pos_;
+    const auto remaining = file_size_ - current_pos_;
+    const auto newline = static_cast<const char*>(std::memchr(begin, '\n', remaining));
+    if (newline == nullptr) {
+        current_pos_ = file_size_;
+        return std::string_view(begin, remaining);
     }
-    if (current_pos_ < file_size_ && data_[current_pos_] == '\n') {
-        current_pos_++;
+    current_pos_ += newline - begin + 1;
+    return std::string_view(begin, newline - begin);
+}
+
+int OpenFile(const char* path, int flags, bool& direct) {
+    if (direct) {
+        const auto fd = open(path, flags | O_DIRECT, S_IRUSR | S_IWUSR);
+        if (fd != -1 || errno != EINVAL) {
+            return fd;
+        }
+        direct = false;
+    }
+    return open(path, flags, S_IRUSR | S_IWUSR);
+}
+
+AlignedBuffer AllocateAligned(std::size_t size, std::size_t alignment) {
+    AlignedBuffer buffer(static_cast<char*>(std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)));
+    if (!buffer && size > 0) {
+        throw std::bad_alloc();
+    }
+    return buffer;
+}
+
+BufferReader::BufferReader(AlignedBuffer buffer, std::size_t size, std::size_t offset)
+    : buffer_(std::move(buffer)) {
+    data_ = buffer_.get() + offset;
+    file_size_ = size;
+}
+
+SliceReader::SliceReader(const std::shared_ptr<MemoryReader>& source, std::size_t offset, std::size_t length)
+    : source_(source) {
+    if (offset + length > source->Size()) {
+        throw std::out_of_range("Slice exceeds data size");
+    }
+    data_ = const_cast<char*>(source->Data()) + offset;
+    file_size_ = length;
+}
+
+StdinStream::StdinStream()
+    : buffer_(std::make_unique<char[]>(kBufferSize)) {
+}
+
+bool StdinStream::Fill() const {
+    if (pos_ < size_) {
+        return true;
+    }
+    if (eof_) {
+        return false;
+    }
+
+    buffer_offset_ += size_;
+    pos_ = 0;
+    size_ = 0;
+    while (true) {
+        const auto read_bytes = read(STDIN_FILENO, buffer_.get(), kBufferSize);
+        if (read_bytes == -1 && errno == EINTR) {
+            continue;
+        }
+        if (read_bytes == -1) {
+            throw std::runtime_error(std::string("Failed to read stdin: ") + strerror(errno));
+        }
+        if (read_bytes == 0) {
+            eof_ = true;
+            return false;
+        }
+        size_ = read_bytes;
+        return true;
     }
-    return line;
 }
 
 void StdinStream::Seekg(int offset, std::ios_base::seekdir dir) {
-    std::cin.seekg(offset, dir);
+    std::size_t target;
+    if (dir == std::ios_base::beg) {
+        target = offset;
+    } else if (dir == std::ios_base::cur) {
+        target = Tellg() + offset;
+    } else {
+        throw std::logic_error("Stdin can not be seeked from the end");
+    }
+    if (target < buffer_offset_) {
+        throw std::out_of_range("Seek position out of range");
+    }
+    while (target > buffer_offset_ + size_) {
+        pos_ = size_;
+        if (!Fill()) {
+            throw std::out_of_range("Seek position out of range");
+        }
+    }
+    pos_ = target - buffer_offset_;
 }
+
 int StdinStream::Peek() const {
-    return std::cin.peek();
+    if (Fill()) {
+        return static_cast<unsigned char>(buffer_[pos_]);
+    }
+    return EOF;
 }
+
 std::size_t StdinStream::Tellg() const {
-    return std::cin.tellg();
+    return buffer_offset_ + pos_;
 }
+
 bool StdinStream::Eof() const {
-    return std::cin.eof();
+    return !Fill();
 }
+
 void StdinStream::Read(char* buffer, std::size_t length) {
-    std::cin.read(buffer, length);
+    while (length > 0) {
+        if (!Fill()) {
+            throw std::out_of_range("Read exceeds input size");
+        }
+        const auto chunk = std::min(length, size_ - pos_);
+        std::memcpy(buffer, buffer_.get() + pos_, chunk);
+        pos_ += chunk;
+        buffer += chunk;
+        length -= chunk;
+    }
 }
+
 void StdinStream::Get(char& ch) {
-    std::cin.get(ch);
+    if (!Fill()) {
+        throw std::out_of_range("Get position out of range");
+    }
+    ch = buffer_[pos_++];
 }
+
 std::string StdinStream::ReadLine() {
-    std::string res;
-    std::cin >> res;
-    return res;
+    std::string line;
+    while (Fill()) {
+        const auto begin = buffer_.get() + pos_;
+        const auto newline = static_cast<const char*>(std::memchr(begin, '\n', size_ - pos_));
+        if (newline != nullptr) {
+            line.append(begin, newline - begin);
+            pos_ += newline - begin + 1;
+            break;
+        }
+        line.append(begin, size_ - pos_);
+        pos_ = size_;
+    }
+    return line;
 }
 
-MmapFileWriter::MmapFileWriter(const char* filename, std::size_t initial_size)
+void OStream::Sync(Durability) {
+    Flush();
+}
+
+void OStream::Close(Durability durability) {
+    Sync(durability);
+}
+
+BufferedFileWriter::BufferedFileWriter(const char* filename, std::size_t size_hint, Durability durability, bool direct)
     : filename_(filename)
-    , size_(initial_size)
-    , current_pos_(0)
-    , data_(nullptr) {
-    fd_ = open(filename, O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+    , durability_(durability)
+    , direct_(direct) {
+    fd_ = OpenFile(filename, O_WRONLY | O_CREAT | O_TRUNC, direct_);
     if (fd_ == -1) {
         throw std::runtime_error(std::string("Failed to open output file: ") + filename + " " + strerror(errno));
     }
+    if (size_hint > 0) {
+        Preallocate(size_hint);
+    }
+}
 
-    Resize(size_);
-    MapFile();
+BufferedFileWriter::~BufferedFileWriter() {
+    if (fd_ == -1) {
+        return;
+    }
+    try {
+        SubmitBuffer();
+        WaitPending();
+        if (direct_) {
+            Truncate();
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << '\n';
+    }
+    // A background write may still use the buffers.
+    if (pending_.valid()) {
+        pending_.wait();
+    }
+    if (close(fd_) == -1) {
+        std::cerr << "Failed to close file: " << strerror(errno) << '\n';
+    }
 }
 
-MmapFileWriter::~MmapFileWriter() {
-    if (data_ && data_ != MAP_FAILED) {
-        if (msync(data_, current_pos_, MS_SYNC) == -1) {
-            std::cerr << "Failed to sync memory: " << strerror(errno) << '\n';
+void BufferedFileWriter::Write(const char* buffer, std::size_t length) {
+    while (length > 0) {
+        if (!buffers_[current_]) {
+            buffers_[current_] = AllocateAligned(kBufferSize, kBufferAlignment);
         }
-        if (munmap(data_, size_) == -1) {
-            std::cerr << "Failed to unmap memory: " << strerror(errno) << '\n';
+        const auto chunk = std::min(length, kBufferSize - size_);
+        std::memcpy(buffers_[current_].get() + size_, buffer, chunk);
+        size_ += chunk;
+        buffer += chunk;
+        length -= chunk;
+        if (size_ == kBufferSize) {
+            SubmitBuffer();
         }
     }
-    if (fd_ != -1) {
-        if (ftruncate(fd_, current_pos_) == -1) {
-            std::cerr << "Failed to truncate file: " << strerror(errno) << '\n';
+}
+
+void BufferedFileWriter::Flush() {
+    Sync(durability_);
+}
+
+void BufferedFileWriter::Sync(Durability durability) {
+    SubmitBuffer();
+    WaitPending();
+    SyncFile(fd_, durability);
+}
+
+void BufferedFileWriter::Close(Durability durability) {
+    SubmitBuffer();
+    WaitPending();
+    if (preallocated_ > file_offset_ + size_ || direct_) {
+        Truncate();
+    }
+    SyncFile(fd_, durability);
+    const auto fd = fd_;
+    fd_ = -1;
+    if (close(fd) == -1) {
+        throw std::runtime_error(std::string("Failed to close file: ") + filename_ + " " + strerror(errno));
+    }
+}
+
+void BufferedFileWriter::SubmitBuffer() {
+    if (size_ == submitted_) {
+        return;
+    }
+    WaitPending();
+
+    auto data = buffers_[current_].get();
+    auto length = size_;
+    std::size_t carry = 0;
+    if (direct_) {
+        carry = size_ % kBufferAlignment;
+        if (carry > 0) {
+            length += kBufferAlignment - carry;
+            std::memset(data + size_, 0, length - size_);
         }
-        if (close(fd_) == -1) {
-            std::cerr << "Failed to close file: " << strerror(errno) << '\n';
+    }
+    if (file_offset_ + length > preallocated_) {
+        Preallocate(std::max(file_offset_ + length, preallocated_ * 2));
+    }
+
+    const auto offset = file_offset_;
+    const auto fd = fd_;
+    pending_ = BackgroundIoPool().Submit([=]() {
+        PWriteAll(fd, data, length, offset);
+    });
+
+    current_ ^= 1;
+    if (carry > 0) {
+        if (!buffers_[current_]) {
+            buffers_[current_] = AllocateAligned(kBufferSize, kBufferAlignment);
         }
+        std::memcpy(buffers_[current_].get(), data + size_ - carry, carry);
     }
+    file_offset_ += size_ - carry;
+    size_ = carry;
+    submitted_ = carry;
 }
 
-void MmapFileWriter::Write(const char* buffer, std::size_t length) {
-    while (current_pos_ + length > size_) {
-        Resize(size_ * 2);
-        MapFile();
+void BufferedFileWriter::WaitPending() {
+    if (pending_.valid()) {
+        pending_.get();
     }
-    if (!std::memcpy(data_ + current_pos_, buffer, length)) {
-        throw std::runtime_error(std::string("Failed to copy memory: ") + strerror(errno));
+}
+
+void BufferedFileWriter::Preallocate(std::size_t size) {
+    // Only a hint for the allocator, file systems without support are fine.
+    // The file size is kept, so a crash never leaves zeros past the data.
+    if (fallocate(fd_, FALLOC_FL_KEEP_SIZE, preallocated_, size - preallocated_) == -1 && errno != EOPNOTSUPP) {
+        throw std::runtime_error(std::string("Failed to preallocate file: ") + filename_ + " " + strerror(errno));
     }
-    current_pos_ += length;
+    preallocated_ = size;
 }
 
-void MmapFileWriter::Flush() {
-    if (msync(data_, current_pos_, MS_SYNC) == -1) {
-        throw std::runtime_error(std::string("Failed to sync file: ") + strerror(errno));
+void BufferedFileWriter::Truncate() {
+    // Releases blocks preallocated past the end of data and drops the padding
+    // of the last O_DIRECT block.
+    if (ftruncate(fd_, file_offset_ + size_) == -1) {
+        throw std::runtime_error(std::string("Failed to truncate file: ") + filename_ + " " + strerror(errno));
     }
 }
 
-void MmapFileWriter::Resize(std::size_t new_size) {
-    if (ftruncate(fd_, new_size) == -1) {
+DirectFileReader::DirectFileReader(const char* filename)
+    : DirectFileReader(filename, 0, SIZE_MAX) {
+}
+
+DirectFileReader::DirectFileReader(const char* filename, std::size_t offset, std::size_t length)
+    : filename_(filename) {
+    bool direct = true;
+    fd_ = OpenFile(filename, O_RDONLY, direct);
+    if (fd_ == -1) {
+        throw std::runtime_error(std::string("Failed to open input file: ") + filename + " " + strerror(errno));
+    }
+    struct stat st;
+    if (fstat(fd_, &st) == -1) {
         close(fd_);
-        throw std::runtime_error(std::string("Failed to resize file: ") + strerror(errno));
+        throw std::runtime_error("Failed to determine file size");
+    }
+    const std::size_t file_size = st.st_size;
+    start_ = std::min(offset, file_size);
+    end_offset_ = start_ + std::min(length, file_size - start_);
+
+    // Blocks are read from aligned offsets, the first one is entered at the
+    // start of the range.
+    block_offset_ = start_ / kAlignment * kAlignment;
+    pos_ = kAlignment + start_ - block_offset_;
+    if (end_offset_ > start_) {
+        buffers_[0] = AllocateAligned(kAlignment + kBlockSize, kAlignment);
+        buffers_[1] = AllocateAligned(kAlignment + kBlockSize, kAlignment);
+        Prefetch(1, block_offset_);
     }
-    data_ = nullptr;
-    size_ = new_size;
 }
 
-void MmapFileWriter::MapFile() {
-    if (data_ && data_ != MAP_FAILED) {
-        if (munmap(data_, size_) == -1) {
-            std::cerr << "Failed to unmap memory: " << strerror(errno) << '\n';
+DirectFileReader::~DirectFileReader() {
+    // The pending read writes into our buffer.
+    if (next_.valid()) {
+        next_.wait();
+    }
+    close(fd_);
+}
+
+void DirectFileReader::Prefetch(std::size_t buffer, std::size_t offset) const {
+    auto task = std::make_shared<std::packaged_task<std::size_t()>>([fd = fd_, data = buffers_[buffer].get() + kAlignment, offset]() {
+        std::size_t size = 0;
+        while (size < kBlockSize) {
+            const auto read_bytes = pread(fd, data + size, kBlockSize - size, offset + size);
+            if (read_bytes == -1 && errno == EINTR) {
+                continue;
+            }
+            if (read_bytes == -1) {
+                throw std::runtime_error(std::string("Failed to read file: ") + strerror(errno));
+            }
+            if (read_bytes == 0) {
+                break;
+            }
+            size += read_bytes;
         }
+        return size;
+    });
+    next_ = task->get_future();
+    BackgroundIoPool().Submit([task]() {
+        (*task)();
+    });
+}
+
+bool DirectFileReader::Fill() const {
+    if (pos_ < end_) {
+        return true;
+    }
+    const auto next_offset = block_offset_ + (end_ - kAlignment);
+    if (next_offset >= end_offset_) {
+        return false;
     }
 
-    data_ = static_cast<char*>(mmap(nullptr, size_, PROT_WRITE, MAP_SHARED, fd_, 0));
-    if (data_ == MAP_FAILED) {
-        close(fd_);
-        throw std::runtime_error(std::string("Failed to mmap file: ") + strerror(errno));
+    const auto size = std::min(next_.get(), end_offset_ - next_offset);
+    if (size == 0) {
+        throw std::runtime_error("Unexpected end of file: " + filename_);
+    }
+    const auto previous = buffers_[current_].get();
+    current_ ^= 1;
+    const auto rewind = std::min(kAlignment, end_ - begin_);
+    std::memcpy(buffers_[current_].get() + kAlignment - rewind, previous + end_ - rewind, rewind);
+
+    pos_ = kAlignment + (pos_ - end_);
+    begin_ = kAlignment - rewind;
+    end_ = kAlignment + size;
+    block_offset_ = next_offset;
+    if (block_offset_ + size < end_offset_) {
+        Prefetch(current_ ^ 1, block_offset_ + size);
+    }
+    return pos_ < end_;
+}
+
+void DirectFileReader::Seekg(int offset, std::ios_base::seekdir dir) {
+    std::size_t target;
+    if (dir == std::ios_base::beg) {
+        target = start_ + offset;
+    } else if (dir == std::ios_base::cur) {
+        target = start_ + Tellg() + offset;
+    } else {
+        target = end_offset_ + offset;
+    }
+    if (target < start_ || target + kAlignment < block_offset_ + begin_ || target > end_offset_) {
+        throw std::out_of_range("Seek position out of range");
+    }
+    while (target > block_offset_ + (end_ - kAlignment)) {
+        pos_ = end_;
+        if (!Fill()) {
+            throw std::out_of_range("Seek position out of range");
+        }
+    }
+    pos_ = target + kAlignment - block_offset_;
+}
+
+int DirectFileReader::Peek() const {
+    if (Fill()) {
+        return static_cast<unsigned char>(buffers_[current_].get()[pos_]);
+    }
+    return EOF;
+}
+
+std::size_t DirectFileReader::Tellg() const {
+    return block_offset_ + pos_ - kAlignment - start_;
+}
+
+bool DirectFileReader::Eof() const {
+    return !Fill();
+}
+
+void DirectFileReader::Read(char* buffer, std::size_t length) {
+    while (length > 0) {
+        if (!Fill()) {
+            throw std::out_of_range("Read exceeds file size");
+        }
+        const auto chunk = std::min(length, end_ - pos_);
+        std::memcpy(buffer, buffers_[current_].get() + pos_, chunk);
+        pos_ += chunk;
+        buffer += chunk;
+        length -= chunk;
+    }
+}
+
+void DirectFileReader::Get(char& ch) {
+    if (!Fill()) {
+        throw std::out_of_range("Get position out of range");
+    }
+    ch = buffers_[current_].get()[pos_++];
+}
+
+std::string DirectFileReader::ReadLine() {
+    std::string line;
+    while (Fill()) {
+        const auto begin = buffers_[current_].get() + pos_;
+        const auto newline = static_cast<const char*>(std::memchr(begin, '\n', end_ - pos_));
+        if (newline != nullptr) {
+            line.append(begin, newline - begin);
+            pos_ += newline - begin + 1;
+            break;
+        }
+        line.append(begin, end_ - pos_);
+        pos_ = end_;
+    }
+    return line;
+}
+
+void MemoryWriter::Write(const char* buffer, std::size_t length) {
+    data_.append(buffer, length);
+}
+
+void MemoryWriter::Flush() {
+}
+
+std::string_view MemoryWriter::GetData() const {
+    return data_;
+}
+
+StdoutStream::StdoutStream()
+    : buffer_(std::make_unique<char[]>(kBufferSize)) {
+}
+
+StdoutStream::~StdoutStream() {
+    try {
+        Flush();
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << '\n';
     }
 }
 
 void StdoutStream::Write(const char* buffer, std::size_t length) {
-    std::cout.write(buffer, length);
+    if (size_ + length > kBufferSize) {
+        Flush();
+    }
+    if (length >= kBufferSize) {
+        WriteAll(STDOUT_FILENO, buffer, length);
+        return;
+    }
+    std::memcpy(buffer_.get() + size_, buffer, length);
+    size_ += length;
 }
 
 void StdoutStream::Flush() {
-    std::cout.flush();
+    WriteAll(STDOUT_FILENO, buffer_.get(), size_);
+    size_ = 0;
 }
 
-std::shared_ptr<OStream> GetOutputStream(const std::string& path) {
+std::shared_ptr<OStream> GetOutputStream(const std::string& path, std::size_t size_hint, Durability durability, bool direct) {
     if (path == "stdout") {
         return std::make_shared<StdoutStream>();
     } else {
-        return std::make_shared<MmapFileWriter>(path.c_str(), 8 * 1024 * 1024);
+        return std::make_shared<BufferedFileWriter>(path.c_str(), size_hint, durability, direct);
+    }
+}
+
+void SyncDirectory(const std::string& path) {
+    ScopedFd dir(open(path.c_str(), O_RDONLY | O_DIRECTORY), true);
+    if (dir.Get() == -1) {
+        throw std::runtime_error("Failed to open directory: " + path + " " + strerror(errno));
+    }
+    if (fsync(dir.Get()) == -1) {
+        throw std::runtime_error("Failed to sync directory: " + path + " " + strerror(errno));
     }
 }
 
-std::shared_ptr<IStream> GetInputStream(const std::string& path) {
+std::shared_ptr<IStream> GetInputStream(const std::string& path, bool direct) {
     if (path == "stdin") {
         return std::make_shared<StdinStream>();
+    } else if (direct) {
+        return std::make_shared<DirectFileReader>(path.c_str());
     } else {
         return std::make_shared<MmapFileReader>(path.c_str());
     }
 }
 
+void CopyStream(const std::string& input_path, const std::string& output_path, Durability durability) {
+    const bool from_stdin = input_path == "stdin";
+    ScopedFd input(from_stdin ? STDIN_FILENO : open(input_path.c_str(), O_RDONLY), !from_stdin);
+    if (input.Get() == -1) {
+        throw std::runtime_error("Failed to open input file: " + input_path + " " + strerror(errno));
+    }
+    const bool to_stdout = output_path == "stdout";
+    // Truncated only after the check, so a rejected copy leaves the file as is.
+    ScopedFd output(to_stdout ? STDOUT_FILENO : open(output_path.c_str(), O_WRONLY | O_CREAT, S_IRUSR | S_IWUSR), !to_stdout);
+    if (output.Get() == -1) {
+        throw std::runtime_error("Failed to open output file: " + output_path + " " + strerror(errno));
+    }
+    const bool output_pipe = IsPipe(output.Get());
+    if (!IsPipe(input.Get()) && !output_pipe) {
+        throw std::runtime_error("Raw copy needs a pipe as input or output");
+    }
+    if (!output_pipe && ftruncate(output.Get(), 0) == -1) {
+        throw std::runtime_error("Failed to truncate output file: " + output_path + " " + strerror(errno));
+    }
+
+    while (true) {
+        const auto copied = splice(input.Get(), nullptr, output.Get(), nullptr, kCopyBlockSize, SPLICE_F_MOVE | SPLICE_F_MORE);
+        if (copied == -1 && errno == EINTR) {
+            continue;
+        }
+        if (copied == -1) {
+            throw std::runtime_error(std::string("Failed to copy data: ") + strerror(errno));
+        }
+        if (copied == 0) {
+            break;
+        }
+    }
+    if (!to_stdout) {
+        SyncFile(output.Get(), durability);
+    }
+}
+
 } // namespace lib::chunk_impl
@@ -1,8 +1,15 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
+#include <future>
 #include <iostream>
 #include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 #include <vector>
 
 namespace lib::chunk_impl {
@@ -10,19 +17,84 @@ namespace lib::chunk_impl {
 class IStream {
 public:
     virtual void Seekg(int offset, std::ios_base::seekdir dir = std::ios_base::cur) = 0;
+    // Next byte as unsigned char, EOF only at the end of the stream.
     virtual int Peek() const = 0;
     virtual std::size_t Tellg() const = 0;
     virtual bool Eof() const = 0;
     virtual void Get(char& ch) = 0;
     virtual void Read(char* buffer, std::size_t length) = 0;
     virtual std::string ReadLine() = 0;
+
+    // Streams backed by memory can hand out views of their bytes instead of
+    // copying. Views stay valid while the stream object is alive.
+    virtual bool SupportsViews() const;
+    virtual std::string_view ReadView(std::size_t length);
+    // Line without the trailing newline.
+    virtual std::string_view ReadLineView();
 };
 
-class MmapFileReader: public IStream {
+// Cursor over bytes owned elsewhere, e.g. a file mapping (see
+// MmapFileReader::GetCursor). Mirrors the reading part of IStream without
+// virtual calls, so decoders templated on the input read primitives straight
+// from memory. Defined inline for the same reason.
+class SpanCursor {
 public:
-    MmapFileReader(const char* filename);
-    ~MmapFileReader();
+    SpanCursor(const char* begin, const char* end)
+        : begin_(begin)
+        , pos_(begin)
+        , end_(end) {
+    }
+
+    int Peek() const {
+        return pos_ < end_ ? static_cast<unsigned char>(*pos_) : EOF;
+    }
+    std::size_t Tellg() const {
+        return pos_ - begin_;
+    }
+    bool Eof() const {
+        return pos_ >= end_;
+    }
+    std::size_t Remaining() const {
+        return end_ - pos_;
+    }
+    bool SupportsViews() const {
+        return true;
+    }
+
+    // Relative to the current position only.
+    void Seekg(std::ptrdiff_t offset) {
+        if (offset < begin_ - pos_ || offset > end_ - pos_) {
+            throw std::out_of_range("Seek position out of range");
+        }
+        pos_ += offset;
+    }
+    void Get(char& ch) {
+        if (pos_ >= end_) {
+            throw std::out_of_range("Get position out of range");
+        }
+        ch = *pos_++;
+    }
+    void Read(char* buffer, std::size_t length) {
+        std::memcpy(buffer, ReadView(length).data(), length);
+    }
+    std::string_view ReadView(std::size_t length) {
+        if (length > static_cast<std::size_t>(end_ - pos_)) {
+            throw std::out_of_range("Read exceeds file size");
+        }
+        std::string_view view(pos_, length);
+        pos_ += length;
+        return view;
+    }
 
+private:
+    const char* begin_;
+    const char* pos_;
+    const char* end_;
+};
+
+// Stream over bytes held in memory, subclasses own them.
+class MemoryReader: public IStream {
+public:
     void Seekg(int offset, std::ios_base::seekdir dir = std::ios_base::cur) override;
     int Peek() const override;
     std::size_t Tellg() const override;
@@ -30,17 +102,71 @@ public:
     void Read(char* buffer, std::size_t length) override;
     void Get(char& ch) override;
     std::string ReadLine() override;
+    bool SupportsViews() const override;
+    std::string_view ReadView(std::size_t length) override;
+    std::string_view ReadLineView() override;
 
-private:
-    int fd_ = -1;
+    // Bytes from the current position to the end of data. The stream position
+    // is not advanced, the cursor is valid while the reader is alive.
+    SpanCursor GetCursor() const;
+    // All bytes, independent of the position.
+    const char* Data() const;
+    std::size_t Size() const;
+
+protected:
     std::size_t file_size_ = 0;
     std::size_t current_pos_ = 0;
     char* data_ = nullptr;
 };
 
+class MmapFileReader: public MemoryReader {
+public:
+    MmapFileReader(const char* filename);
+    ~MmapFileReader();
+
+private:
+    int fd_ = -1;
+};
+
+struct FreeDeleter {
+    void operator()(char* ptr) const {
+        std::free(ptr);
+    }
+};
+using AlignedBuffer = std::unique_ptr<char, FreeDeleter>;
+
+// open(2) with O_DIRECT when direct is set. Where the file system rejects
+// O_DIRECT the file is opened without it and direct is cleared.
+int OpenFile(const char* path, int flags, bool& direct);
+
+// Throws std::bad_alloc, size is rounded up to a multiple of alignment.
+AlignedBuffer AllocateAligned(std::size_t size, std::size_t alignment);
+
+// Owns a file read into memory, see ReadFiles. Data starts at offset.
+class BufferReader: public MemoryReader {
+public:
+    BufferReader(AlignedBuffer buffer, std::size_t size, std::size_t offset = 0);
+
+private:
+    AlignedBuffer buffer_;
+};
+
+// Part of the data of another memory reader, which is kept alive.
+class SliceReader: public MemoryReader {
+public:
+    SliceReader(const std::shared_ptr<MemoryReader>& source, std::size_t offset, std::size_t length);
+
+private:
+    std::shared_ptr<MemoryReader> source_;
+};
+
+// Reads standard input with raw read(2) calls into a large buffer, binary safe.
+// Seeking is limited to skipping forward and moving back within the buffer.
 class StdinStream: public IStream {
 public:
-    StdinStream() = default;
+    static constexpr std::size_t kBufferSize = 1 << 20;
+
+    StdinStream();
     ~StdinStream() = default;
     void Seekg(int offset, std::ios_base::seekdir dir = std::ios_base::cur) override;
     int Peek() const override;
@@ -49,41 +175,180 @@ public:
     void Read(char* buffer, std::size_t length) override;
     void Get(char& ch) override;
     std::string ReadLine() override;
+
+private:
+    // Makes sure there are unread bytes in the buffer, false at the end of input.
+    bool Fill() const;
+
+    mutable std::unique_ptr<char[]> buffer_;
+    // Input offset of the first buffered byte.
+    mutable std::size_t buffer_offset_ = 0;
+    mutable std::size_t size_ = 0;
+    mutable std::size_t pos_ = 0;
+    mutable bool eof_ = false;
 };
 
+// How far written data is pushed towards the disk when an output stream is
+// flushed or closed.
+enum class Durability {
+    // Left to the page cache.
+    None,
+    // Writeback is started, nothing waits for it.
+    Async,
+    // Returns once the data is on disk.
+    Full,
+};
+
+// Accepts "none", "async" and "full".
+Durability ParseDurability(const std::string& name);
+
 class OStream {
 public:
     virtual void Write(const char* buffer, std::size_t length) = 0;
+    // Applies the durability the stream was opened with.
     virtual void Flush() = 0;
+    // Applies the given durability instead, e.g. to start writeback of many
+    // files before waiting for any of them. Flushes by default.
+    virtual void Sync(Durability durability);
+    // Writes the last data and applies durability, nothing is written after.
+    // Syncs by default.
+    virtual void Close(Durability durability);
 };
 
-class MmapFileWriter: public OStream {
+// Writes a file through large aligned buffers. A filled buffer is written with
+// pwrite(2) on a background thread while the next one is being filled, so the
+// caller only waits when both buffers are busy. Disk space is preallocated with
+// fallocate(2) from the size hint and then in doubling steps without changing
+// the file size, the unused tail is released on close. With direct, the file is
+// written with O_DIRECT bypassing the page cache, where the file system
+// supports it.
+class BufferedFileWriter: public OStream {
 public:
-    MmapFileWriter(const char* filename, std::size_t initial_size);
-    ~MmapFileWriter();
+    static constexpr std::size_t kBufferSize = 1 << 20;
+    static constexpr std::size_t kBufferAlignment = 4096;
+
+    BufferedFileWriter(const char* filename, std::size_t size_hint = 0, Durability durability = Durability::Full, bool direct = false);
+    // Without Close, writes out buffered data without syncing it, errors are
+    // reported to stderr.
+    ~BufferedFileWriter();
     void Write(const char* buffer, std::size_t length) override;
     void Flush() override;
+    void Sync(Durability durability) override;
+    // Truncates the file to the written size before the final sync, dropping
+    // preallocated blocks and O_DIRECT block padding.
+    void Close(Durability durability) override;
 
 private:
-    void Resize(std::size_t new_size);
-    void MapFile();
+    // Hands the current buffer to the background writer and switches to the other one.
+    void SubmitBuffer();
+    void WaitPending();
+    void Preallocate(std::size_t size);
+    void Truncate();
 
-    const char* filename_;
-    int fd_;
-    std::size_t size_;
-    std::size_t current_pos_;
-    char* data_ = nullptr;
+    std::string filename_;
+    Durability durability_;
+    bool direct_;
+    int fd_ = -1;
+    // Allocated on first use, small files never touch the second one.
+    AlignedBuffer buffers_[2];
+    std::size_t current_ = 0;
+    std::size_t size_ = 0;
+    // Leading bytes of the current buffer already written. O_DIRECT writes
+    // whole blocks, a partial last block is written again with what follows.
+    std::size_t submitted_ = 0;
+    // File offset the current buffer starts at.
+    std::size_t file_offset_ = 0;
+    std::size_t preallocated_ = 0;
+    std::future<void> pending_;
+};
+
+// Streams a file with O_DIRECT, bypassing the page cache, so that scans much
+// larger than memory do not evict other data. The next block is read on a
+// background thread while the current one is decoded. Seeking back is limited
+// to the current block and kAlignment bytes before it. Falls back to cached
+// reads where the file system does not support O_DIRECT. Can be limited to a
+// range of the file, positions are then relative to its start.
+class DirectFileReader: public IStream {
+public:
+    static constexpr std::size_t kBlockSize = 1 << 20;
+    static constexpr std::size_t kAlignment = 4096;
+
+    DirectFileReader(const char* filename);
+    DirectFileReader(const char* filename, std::size_t offset, std::size_t length);
+    ~DirectFileReader();
+    void Seekg(int offset, std::ios_base::seekdir dir = std::ios_base::cur) override;
+    int Peek() const override;
+    std::size_t Tellg() const override;
+    bool Eof() const override;
+    void Read(char* buffer, std::size_t length) override;
+    void Get(char& ch) override;
+    std::string ReadLine() override;
+
+private:
+    // Makes sure there are unread bytes in the block, false at the end of file.
+    bool Fill() const;
+    void Prefetch(std::size_t buffer, std::size_t offset) const;
+
+    std::string filename_;
+    int fd_ = -1;
+    // File offsets of the range.
+    std::size_t start_ = 0;
+    std::size_t end_offset_ = 0;
+    // Block data starts at kAlignment, the bytes before it repeat the end of
+    // the previous block.
+    mutable AlignedBuffer buffers_[2];
+    mutable std::size_t current_ = 0;
+    // File offset of the current block.
+    mutable std::size_t block_offset_ = 0;
+    // Indices into the current buffer.
+    mutable std::size_t begin_ = kAlignment;
+    mutable std::size_t end_ = kAlignment;
+    mutable std::size_t pos_ = kAlignment;
+    // Size of the next block, read into the other buffer.
+    mutable std::future<std::size_t> next_;
+};
+
+// Collects written bytes in memory, e.g. parts of a file assembled later.
+class MemoryWriter: public OStream {
+public:
+    void Write(const char* buffer, std::size_t length) override;
+    void Flush() override;
+
+    std::string_view GetData() const;
+
+private:
+    std::string data_;
 };
 
+// Writes standard output with raw write(2) calls from a large buffer, writes
+// larger than the buffer go to the descriptor directly.
 class StdoutStream: public OStream {
 public:
-    StdoutStream() = default;
-    ~StdoutStream() = default;
+    static constexpr std::size_t kBufferSize = 1 << 20;
+
+    StdoutStream();
+    ~StdoutStream();
     void Write(const char* buffer, std::size_t length) override;
     void Flush() override;
+
+private:
+    std::unique_ptr<char[]> buffer_;
+    std::size_t size_ = 0;
 };
 
-std::shared_ptr<OStream> GetOutputStream(const std::string& path);
-std::shared_ptr<IStream> GetInputStream(const std::string& path);
+// Files are preallocated for size_hint bytes when it is known. With direct,
+// files bypass the page cache (see BufferedFileWriter and DirectFileReader).
+std::shared_ptr<OStream> GetOutputStream(const std::string& path, std::size_t size_hint = 0, Durability durability = Durability::Full, bool direct = false);
+std::shared_ptr<IStream> GetInputStream(const std::string& path, bool direct = false);
+
+// Makes creation of the directory entries durable, files themselves are
+// synced through their streams.
+void SyncDirectory(const std::string& path);
+
+// Copies raw bytes between paths, "stdin" and "stdout" included, with
+// splice(2), so the data does not pass through user space. Either end must be
+// a pipe. Nothing is validated. Output files are synced according to
+// durability.
+void CopyStream(const std::string& input_path, const std::string& output_path, Durability durability = Durability::Full);
 
 } // namespace lib::chunk_impl
@@ -1,186 +1,704 @@
 #include "json.h"
 
+#include <array>
+#include <charconv>
+#include <cmath>
 #include <fstream>
 #include <iterator>
 
-#include <rapidjson/document.h>
-#include <rapidjson/stringbuffer.h>
-#include <rapidjson/writer.h>
+#include <rapidjson/memorystream.h>
+#include <rapidjson/reader.h>
 
 #include <lib/chunk_impl/io.h>
+#include <lib/chunk_impl/thread_pool.h>
+#include <lib/document/arena.h>
 
 namespace lib::chunk_impl {
 
 namespace {
 
-    std::shared_ptr<document::Value> ParseRapidJsonValue(rapidjson::Value&& value, const TreeNodePtr& root) {
-        if (value.IsNull()) {
-            return std::static_pointer_cast<document::Value>(std::make_shared<document::Null>());
+    constexpr double kMaxFloat32 = 3.4028234e38;
+
+    // Sinks build values of a particular representation for JsonHandler.
+    // Containers are built in stack order: nested values are finished before
+    // they are added to the enclosing container.
+    class TreeSink {
+    public:
+        using ValueType = std::shared_ptr<document::Value>;
+
+        explicit TreeSink(const document::ArenaPtr& arena)
+            : arena_(arena) {
         }
-        if (value.IsBool()) {
-            return std::static_pointer_cast<document::Value>(std::make_shared<document::Boolean>(value.GetBool()));
+
+        ValueType MakeNull() {
+            return std::static_pointer_cast<document::Value>(document::MakeValue<document::Null>(arena_));
         }
-        if (value.IsUint()) {
-            return std::static_pointer_cast<document::Value>(std::make_shared<document::UInt32>(value.GetUint()));
+        ValueType MakeBoolean(bool value) {
+            return std::static_pointer_cast<document::Value>(document::MakeValue<document::Boolean>(arena_, value));
         }
-        if (value.IsUint64()) {
-            return std::static_pointer_cast<document::Value>(std::make_shared<document::UInt64>(value.GetUint64()));
+        ValueType MakeInt32(int32_t value) {
+            return std::static_pointer_cast<document::Value>(document::MakeValue<document::Int32>(arena_, value));
         }
-        if (value.IsInt()) {
-            return std::static_pointer_cast<document::Value>(std::make_shared<document::Int32>(value.GetInt()));
+        ValueType MakeUInt32(uint32_t value) {
+            return std::static_pointer_cast<document::Value>(document::MakeValue<document::UInt32>(arena_, value));
         }
-        if (value.IsInt64()) {
-            return std::static_pointer_cast<document::Value>(std::make_shared<document::Int64>(value.GetInt64()));
+        ValueType MakeInt64(int64_t value) {
+            return std::static_pointer_cast<document::Value>(document::MakeValue<document::Int64>(arena_, value));
         }
-        if (value.IsFloat()) {
-            return std::static_pointer_cast<document::Value>(std::make_shared<document::Float32>(value.GetFloat()));
+        ValueType MakeUInt64(uint64_t value) {
+            return std::static_pointer_cast<document::Value>(document::MakeValue<document::UInt64>(arena_, value));
         }
-        if (value.IsDouble()) {
-            return std::static_pointer_cast<document::Value>(std::make_shared<document::Float64>(value.GetDouble()));
+        ValueType MakeFloat32(float value) {
+            return std::static_pointer_cast<document::Value>(document::MakeValue<document::Float32>(arena_, value));
         }
-        if (value.IsString()) {
-            return std::static_pointer_cast<document::Value>(std::make_shared<document::String>(value.GetString()));
+        ValueType MakeFloat64(double value) {
+            return std::static_pointer_cast<document::Value>(document::MakeValue<document::Float64>(arena_, value));
+        }
+        ValueType MakeString(std::string_view value) {
+            return std::static_pointer_cast<document::Value>(document::MakeValue<document::String>(arena_, value, document::GetResource(arena_)));
         }
-        if (value.IsObject()) {
-            document::ValueMap doc_map;
-            for (auto&& m : value.GetObject()) {
-                auto key = m.name.GetString();
-                if (root->IsLeaf()) {
-                    doc_map[key] = ParseRapidJsonValue(std::move(m.value), root);
-                    continue;
-                }
 
-                const auto it = root->children.find(key);
-                if (it == root->children.end()) {
-                    continue;
-                }
+        void StartDocument() {
+            maps_.emplace_back(document::GetResource(arena_));
+        }
+        void AddField(document::KeyId key, ValueType&& value) {
+            maps_.back()[key] = std::move(value);
+        }
+        ValueType FinishDocument() {
+            auto doc_map = std::move(maps_.back());
+            maps_.pop_back();
+            return std::static_pointer_cast<document::Value>(document::MakeValue<document::Document>(arena_, std::move(doc_map)));
+        }
+
+        void StartList() {
+            lists_.emplace_back(document::GetResource(arena_));
+        }
+        void AddItem(ValueType&& value) {
+            lists_.back().push_back(std::move(value));
+        }
+        ValueType FinishList() {
+            auto list = std::move(lists_.back());
+            lists_.pop_back();
+            return std::static_pointer_cast<document::Value>(document::MakeValue<document::List>(arena_, std::move(list)));
+        }
 
-                doc_map[key] = ParseRapidJsonValue(std::move(m.value), it->second);
+    private:
+        document::ArenaPtr arena_;
+        std::vector<document::ValueMap> maps_;
+        std::vector<document::ValueList> lists_;
+    };
+
+    class CompactSink {
+    public:
+        using ValueType = document::CompactValue;
+
+        explicit CompactSink(document::CompactBuilder& builder)
+            : builder_(builder) {
+        }
+
+        ValueType MakeNull() {
+            return document::CompactValue::Null();
+        }
+        ValueType MakeBoolean(bool value) {
+            return document::CompactValue::Boolean(value);
+        }
+        ValueType MakeInt32(int32_t value) {
+            return document::CompactValue::Int32(value);
+        }
+        ValueType MakeUInt32(uint32_t value) {
+            return document::CompactValue::UInt32(value);
+        }
+        ValueType MakeInt64(int64_t value) {
+            return document::CompactValue::Int64(value);
+        }
+        ValueType MakeUInt64(uint64_t value) {
+            return document::CompactValue::UInt64(value);
+        }
+        ValueType MakeFloat32(float value) {
+            return document::CompactValue::Float32(value);
+        }
+        ValueType MakeFloat64(double value) {
+            return document::CompactValue::Float64(value);
+        }
+        ValueType MakeString(std::string_view value) {
+            return builder_.MakeString(value);
+        }
+
+        void StartDocument() {
+            marks_.push_back(builder_.StartDocument());
+        }
+        void AddField(document::KeyId key, ValueType&& value) {
+            builder_.AddField(key, value);
+        }
+        ValueType FinishDocument() {
+            const auto mark = marks_.back();
+            marks_.pop_back();
+            return builder_.FinishDocument(mark);
+        }
+
+        void StartList() {
+            marks_.push_back(builder_.StartList());
+        }
+        void AddItem(ValueType&& value) {
+            builder_.AddItem(value);
+        }
+        ValueType FinishList() {
+            const auto mark = marks_.back();
+            marks_.pop_back();
+            return builder_.FinishList(mark);
+        }
+
+    private:
+        document::CompactBuilder& builder_;
+        std::vector<std::size_t> marks_;
+    };
+
+    // SAX handler building values directly from parser events, without an
+    // intermediate rapidjson DOM. Keys outside of the projection are dropped as
+    // soon as they are read, events of their values are ignored.
+    template <typename Sink>
+    class JsonHandler {
+    public:
+        JsonHandler(const TreeNodePtr& root, Sink& sink)
+            : root_(root)
+            , sink_(sink) {
+        }
+
+        bool Null() {
+            return Skip(0) || EmitScalar(sink_.MakeNull());
+        }
+        bool Bool(bool value) {
+            return Skip(0) || EmitScalar(sink_.MakeBoolean(value));
+        }
+        bool Int(int value) {
+            return Skip(0) || EmitScalar(sink_.MakeInt32(value));
+        }
+        bool Uint(unsigned value) {
+            return Skip(0) || EmitScalar(sink_.MakeUInt32(value));
+        }
+        bool Int64(int64_t value) {
+            return Skip(0) || EmitScalar(sink_.MakeInt64(value));
+        }
+        bool Uint64(uint64_t value) {
+            return Skip(0) || EmitScalar(sink_.MakeUInt64(value));
+        }
+        bool Double(double value) {
+            // Doubles within float range are narrowed, as rapidjson's IsFloat did.
+            if (value >= -kMaxFloat32 && value <= kMaxFloat32) {
+                return Skip(0) || EmitScalar(sink_.MakeFloat32(static_cast<float>(value)));
             }
-            return std::static_pointer_cast<document::Value>(std::make_shared<document::Document>(std::move(doc_map)));
+            return Skip(0) || EmitScalar(sink_.MakeFloat64(value));
+        }
+        bool RawNumber(const char*, rapidjson::SizeType, bool) {
+            throw std::logic_error("Numbers are not parsed as strings");
         }
-        if (value.IsArray()) {
-            auto arr = value.GetArray();
-            document::ValueList list;
-            list.reserve(arr.Size());
-            for (auto&& v : arr) {
-                list.push_back(ParseRapidJsonValue(std::move(v), root));
+        bool String(const char* value, rapidjson::SizeType length, bool) {
+            return Skip(0) || EmitScalar(sink_.MakeString(std::string_view(value, length)));
+        }
+
+        bool StartObject() {
+            if (Skip(1)) {
+                return true;
             }
-            return std::static_pointer_cast<document::Value>(std::make_shared<document::List>(std::move(list)));
+            frames_.push_back(Frame{NextNode(), nullptr, false});
+            sink_.StartDocument();
+            return true;
+        }
+        bool Key(const char* value, rapidjson::SizeType length, bool) {
+            if (skipping_) {
+                return true;
+            }
+            auto& frame = frames_.back();
+            if (frame.node->IsLeaf()) {
+                frame.key = document::InternKey(std::string_view(value, length));
+                frame.value_node = frame.node;
+                return true;
+            }
+            // Keys outside the projection are never interned.
+            const auto key = document::FindKey(std::string_view(value, length));
+            const auto it = key ? frame.node->children.find(*key) : frame.node->children.end();
+            if (it == frame.node->children.end()) {
+                skipping_ = true;
+                return true;
+            }
+            frame.key = *key;
+            frame.value_node = it->second;
+            return true;
+        }
+        bool EndObject(rapidjson::SizeType) {
+            if (Skip(-1)) {
+                return true;
+            }
+            frames_.pop_back();
+            return Emit(sink_.FinishDocument());
         }
 
-        throw std::runtime_error("Type is not supported");
-    }
+        bool StartArray() {
+            if (Skip(1)) {
+                return true;
+            }
+            if (frames_.empty()) {
+                throw std::runtime_error("JSON is not an object");
+            }
+            const auto node = NextNode();
+            frames_.push_back(Frame{node, node, true});
+            sink_.StartList();
+            return true;
+        }
+        bool EndArray(rapidjson::SizeType) {
+            if (Skip(-1)) {
+                return true;
+            }
+            frames_.pop_back();
+            return Emit(sink_.FinishList());
+        }
 
-    std::shared_ptr<document::Document> ReadJsonLine(std::string&& line, const TreeNodePtr& tree) {
-        rapidjson::Document doc;
+        typename Sink::ValueType GetResult() {
+            return std::move(result_);
+        }
 
-        if (doc.Parse(line.c_str()).HasParseError()) {
-            throw std::runtime_error("Failed to parse JSON");
+    private:
+        struct Frame {
+            TreeNodePtr node;
+            // Projection of the value being parsed, lists pass theirs to items.
+            TreeNodePtr value_node;
+            bool is_list;
+            document::KeyId key = 0;
+        };
+
+        // Whether the event belongs to a dropped value, depth_change tracks nesting within it.
+        bool Skip(int depth_change) {
+            if (!skipping_) {
+                return false;
+            }
+            skip_depth_ += depth_change;
+            if (skip_depth_ == 0) {
+                skipping_ = false;
+            }
+            return true;
         }
 
-        if (!doc.IsObject()) {
-            throw std::runtime_error("JSON is not an object");
+        TreeNodePtr NextNode() const {
+            return frames_.empty() ? root_ : frames_.back().value_node;
         }
 
-        return std::static_pointer_cast<document::Document>(ParseRapidJsonValue(doc.GetObject(), tree));
-    }
+        bool EmitScalar(typename Sink::ValueType&& value) {
+            if (frames_.empty()) {
+                throw std::runtime_error("JSON is not an object");
+            }
+            return Emit(std::move(value));
+        }
 
-} // namespace
+        bool Emit(typename Sink::ValueType&& value) {
+            if (frames_.empty()) {
+                result_ = std::move(value);
+                return true;
+            }
+            auto& frame = frames_.back();
+            if (frame.is_list) {
+                sink_.AddItem(std::move(value));
+            } else {
+                sink_.AddField(frame.key, std::move(value));
+            }
+            return true;
+        }
 
-std::vector<std::shared_ptr<document::Document>> JsonChunk::Read(const TreeNodePtr& tree) const {
-    auto stream = GetInputStream(path);
+        TreeNodePtr root_;
+        Sink& sink_;
+        std::vector<Frame> frames_;
+        bool skipping_ = false;
+        int skip_depth_ = 0;
+        typename Sink::ValueType result_;
+    };
 
-    std::vector<std::shared_ptr<document::Document>> res;
-    while (!stream->Eof()) {
-        std::string line = stream->ReadLine();
-        if (line.empty()) {
-            break;
+    template <typename Sink>
+    typename Sink::ValueType ParseJsonLine(std::string_view line, const TreeNodePtr& tree, Sink& sink) {
+        JsonHandler<Sink> handler(tree, sink);
+        rapidjson::Reader reader;
+        rapidjson::MemoryStream stream(line.data(), line.size());
+        if (reader.Parse<rapidjson::kParseDefaultFlags>(stream, handler).IsError()) {
+            throw std::runtime_error("Failed to parse JSON");
         }
+        return handler.GetResult();
+    }
 
-        res.emplace_back(ReadJsonLine(std::move(line), tree));
+    std::shared_ptr<document::Document> ReadJsonLine(std::string_view line, const TreeNodePtr& tree, const document::ArenaPtr& arena) {
+        TreeSink sink(arena);
+        return std::static_pointer_cast<document::Document>(ParseJsonLine(line, tree, sink));
     }
 
-    return res;
-}
+    document::CompactValue ReadCompactJsonLine(std::string_view line, const TreeNodePtr& tree, document::CompactBuilder& builder) {
+        CompactSink sink(builder);
+        return ParseJsonLine(line, tree, sink);
+    }
 
-namespace {
+    // Characters escaped in JSON strings: 0 for none, 'u' for \u00XX, otherwise
+    // the letter following the backslash.
+    constexpr std::array<char, 256> kEscapes = []() {
+        std::array<char, 256> escapes{};
+        for (std::size_t c = 0; c < 0x20; ++c) {
+            escapes[c] = 'u';
+        }
+        escapes['\b'] = 'b';
+        escapes['\f'] = 'f';
+        escapes['\n'] = 'n';
+        escapes['\r'] = 'r';
+        escapes['\t'] = 't';
+        escapes['"'] = '"';
+        escapes['\\'] = '\\';
+        return escapes;
+    }();
+
+    constexpr std::size_t kFlushThreshold = 1 << 20;
+
+    // Serializes values straight into a reusable buffer that is passed to the
+    // stream in large blocks, without building a rapidjson DOM or a string per
+    // document.
+    class JsonEncoder {
+    public:
+        explicit JsonEncoder(const std::shared_ptr<OStream>& stream)
+            : stream_(stream) {
+            buffer_.reserve(kFlushThreshold + kFlushThreshold / 4);
+        }
 
-    rapidjson::Value ValueToRapidJsonValue(const std::shared_ptr<document::Value>& value, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator>& allocator) {
-        rapidjson::Value rj_value;
-        switch (value->GetTypeId()) {
-            case document::TypeId::kNull:
-                rj_value.SetNull();
-                return rj_value;
-            case document::TypeId::kBoolean:
-                rj_value.SetBool(std::static_pointer_cast<document::Boolean>(value)->value);
-                return rj_value;
-            case document::TypeId::kInt32:
-                rj_value.SetInt(std::static_pointer_cast<document::Int32>(value)->value);
-                return rj_value;
-            case document::TypeId::kUint32:
-                rj_value.SetUint(std::static_pointer_cast<document::UInt32>(value)->value);
-                return rj_value;
-            case document::TypeId::kInt64:
-                rj_value.SetInt64(std::static_pointer_cast<document::Int64>(value)->value);
-                return rj_value;
-            case document::TypeId::kUint64:
-                rj_value.SetUint64(std::static_pointer_cast<document::UInt64>(value)->value);
-                return rj_value;
-            case document::TypeId::kFloat32:
-                rj_value.SetFloat(std::static_pointer_cast<document::Float32>(value)->value);
-                return rj_value;
-            case document::TypeId::kFloat64:
-                rj_value.SetDouble(std::static_pointer_cast<document::Float64>(value)->value);
-                return rj_value;
-            case document::TypeId::kString:
-                rj_value.SetString(std::static_pointer_cast<document::String>(value)->value.c_str(), allocator);
-                return rj_value;
-            case document::TypeId::kDocument: {
-                rj_value.SetObject();
-                const auto& derived = std::static_pointer_cast<document::Document>(value);
-                for (const auto& [k, v] : derived->value) {
-                    rapidjson::Value obj_key(k.c_str(), allocator);
-                    rapidjson::Value obj_value = ValueToRapidJsonValue(v, allocator);
-                    rj_value.AddMember(std::move(obj_key), std::move(obj_value), allocator);
+        void Encode(const std::shared_ptr<document::Value>& value) {
+            switch (value->GetTypeId()) {
+                case document::TypeId::kNull:
+                    Append("null");
+                    return;
+                case document::TypeId::kBoolean:
+                    Append(std::static_pointer_cast<document::Boolean>(value)->value ? "true" : "false");
+                    return;
+                case document::TypeId::kInt32:
+                    AppendInteger(std::static_pointer_cast<document::Int32>(value)->value);
+                    return;
+                case document::TypeId::kUint32:
+                    AppendInteger(std::static_pointer_cast<document::UInt32>(value)->value);
+                    return;
+                case document::TypeId::kInt64:
+                    AppendInteger(std::static_pointer_cast<document::Int64>(value)->value);
+                    return;
+                case document::TypeId::kUint64:
+                    AppendInteger(std::static_pointer_cast<document::UInt64>(value)->value);
+                    return;
+                case document::TypeId::kFloat32:
+                    AppendFloating(std::static_pointer_cast<document::Float32>(value)->value);
+                    return;
+                case document::TypeId::kFloat64:
+                    AppendFloating(std::static_pointer_cast<document::Float64>(value)->value);
+                    return;
+                case document::TypeId::kString:
+                    AppendString(std::static_pointer_cast<document::String>(value)->value);
+                    return;
+                case document::TypeId::kDocument: {
+                    buffer_.push_back('{');
+                    bool first = true;
+                    for (const auto& [k, v] : std::static_pointer_cast<document::Document>(value)->value) {
+                        if (!first) {
+                            buffer_.push_back(',');
+                        }
+                        first = false;
+                        AppendString(document::KeyName(k));
+                        buffer_.push_back(':');
+                        Encode(v);
+                    }
+                    buffer_.push_back('}');
+                    return;
                 }
-                return rj_value;
-            }
-            case document::TypeId::kList: {
-                rj_value.SetArray();
-                const auto& derived = std::static_pointer_cast<document::List>(value);
-                for (const auto& v : derived->value) {
-                    rapidjson::Value obj_value = ValueToRapidJsonValue(v, allocator);
-                    rj_value.PushBack(std::move(obj_value), allocator);
+                case document::TypeId::kList: {
+                    buffer_.push_back('[');
+                    bool first = true;
+                    for (const auto& v : std::static_pointer_cast<document::List>(value)->value) {
+                        if (!first) {
+                            buffer_.push_back(',');
+                        }
+                        first = false;
+                        Encode(v);
+                    }
+                    buffer_.push_back(']');
+                    return;
                 }
-                return rj_value;
             }
         }
-    }
 
-    std::string DocumentToJson(const std::shared_ptr<document::Document>& document) {
-        rapidjson::Document rj_doc;
-        rj_doc.SetObject();
+        void Encode(const document::CompactValue& value) {
+            switch (value.GetTypeId()) {
+                case document::TypeId::kNull:
+                    Append("null");
+                    return;
+                case document::TypeId::kBoolean:
+                    Append(value.GetBoolean() ? "true" : "false");
+                    return;
+                case document::TypeId::kInt32:
+                    AppendInteger(value.GetInt32());
+                    return;
+                case document::TypeId::kUint32:
+                    AppendInteger(value.GetUInt32());
+                    return;
+                case document::TypeId::kInt64:
+                    AppendInteger(value.GetInt64());
+                    return;
+                case document::TypeId::kUint64:
+                    AppendInteger(value.GetUInt64());
+                    return;
+                case document::TypeId::kFloat32:
+                    AppendFloating(value.GetFloat32());
+                    return;
+                case document::TypeId::kFloat64:
+                    AppendFloating(value.GetFloat64());
+                    return;
+                case document::TypeId::kString:
+                    AppendString(value.GetString());
+                    return;
+                case document::TypeId::kDocument:
+                    buffer_.push_back('{');
+                    for (auto it = value.FieldsBegin(); it != value.FieldsEnd(); ++it) {
+                        if (it != value.FieldsBegin()) {
+                            buffer_.push_back(',');
+                        }
+                        AppendString(document::KeyName(it->key));
+                        buffer_.push_back(':');
+                        Encode(it->value);
+                    }
+                    buffer_.push_back('}');
+                    return;
+                case document::TypeId::kList:
+                    buffer_.push_back('[');
+                    for (auto it = value.ItemsBegin(); it != value.ItemsEnd(); ++it) {
+                        if (it != value.ItemsBegin()) {
+                            buffer_.push_back(',');
+                        }
+                        Encode(*it);
+                    }
+                    buffer_.push_back(']');
+                    return;
+                default:
+                    throw std::logic_error("Unreachable code");
+            }
+        }
+
+        // Terminates a JSONL record, the buffer is flushed once it is large enough.
+        void EndLine() {
+            buffer_.push_back('\n');
+            if (buffer_.size() >= kFlushThreshold) {
+                Flush();
+            }
+        }
+
+        void Flush() {
+            if (!buffer_.empty()) {
+                stream_->Write(buffer_.data(), buffer_.size());
+                buffer_.clear();
+            }
+        }
 
-        auto rj_value = ValueToRapidJsonValue(std::static_pointer_cast<document::Value>(document), rj_doc.GetAllocator());
-        rj_doc.Swap(rj_value);
+    private:
+        void Append(std::string_view value) {
+            buffer_.append(value);
+        }
 
-        rapidjson::StringBuffer buffer;
-        rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
-        rj_doc.Accept(writer);
+        template <typename T>
+        void AppendInteger(T value) {
+            char chars[24];
+            const auto res = std::to_chars(chars, chars + sizeof(chars), value);
+            buffer_.append(chars, res.ptr);
+        }
+
+        // Shortest representation that reads back to the same value. Integral
+        // values keep a fraction so that they are not read back as integers.
+        template <typename T>
+        void AppendFloating(T value) {
+            if (!std::isfinite(value)) {
+                Append("null");
+                return;
+            }
+            char chars[32];
+            const auto res = std::to_chars(chars, chars + sizeof(chars), value);
+            const std::string_view str(chars, res.ptr - chars);
+            buffer_.append(str);
+            if (str.find_first_of(".e") == std::string_view::npos) {
+                Append(".0");
+            }
+        }
+
+        void AppendString(std::string_view value) {
+            buffer_.push_back('"');
+            std::size_t plain_from = 0;
+            for (std::size_t i = 0; i < value.size(); ++i) {
+                const auto escape = kEscapes[static_cast<unsigned char>(value[i])];
+                if (escape == 0) {
+                    continue;
+                }
+                buffer_.append(value.data() + plain_from, i - plain_from);
+                plain_from = i + 1;
+                buffer_.push_back('\\');
+                buffer_.push_back(escape);
+                if (escape == 'u') {
+                    constexpr char kHex[] = "0123456789ABCDEF";
+                    const auto c = static_cast<unsigned char>(value[i]);
+                    Append("00");
+                    buffer_.push_back(kHex[c >> 4]);
+                    buffer_.push_back(kHex[c & 0xF]);
+                }
+            }
+            buffer_.append(value.data() + plain_from, value.size() - plain_from);
+            buffer_.push_back('"');
+        }
+
+        std::shared_ptr<OStream> stream_;
+        std::string buffer_;
+    };
+
+    class JsonReader: public ChunkReader {
+    public:
+        JsonReader(const std::string& path, const TreeNodePtr& tree, const ChunkOptions& options)
+            : ChunkReader(options)
+            , stream_(GetInputStream(path, options.direct_io))
+            , tree_(tree) {
+            if (options.parse_threads > 1 && stream_->SupportsViews()) {
+                pool_ = std::make_unique<ThreadPool>(options.parse_threads);
+            }
+        }
+
+        std::vector<std::shared_ptr<document::Document>> NextBatch() override {
+            if (pool_ != nullptr) {
+                return NextBatchParallel();
+            }
+
+            auto arena = options.use_arena ? std::make_shared<document::Arena>() : nullptr;
+
+            std::vector<std::shared_ptr<document::Document>> res;
+            while (res.size() < options.batch_size && !stream_->Eof()) {
+                std::string line = stream_->ReadLine();
+                if (line.empty()) {
+                    break;
+                }
+
+                res.emplace_back(ReadJsonLine(line, tree_, arena));
+            }
+
+            return res;
+        }
+
+        document::CompactBatch NextCompactBatch() override {
+            if (pool_ != nullptr) {
+                return NextCompactBatchParallel();
+            }
+
+            document::CompactBatch result;
+            result.arena = std::make_shared<document::Arena>();
+            document::CompactBuilder builder(result.arena);
+
+            while (result.documents.size() < options.batch_size && !stream_->Eof()) {
+                std::string line = stream_->ReadLine();
+                if (line.empty()) {
+                    break;
+                }
+
+                result.documents.push_back(ReadCompactJsonLine(line, tree_, builder));
+            }
+
+            return result;
+        }
+
+    private:
+        std::vector<std::string_view> ReadLineViews() {
+            std::vector<std::string_view> lines;
+            while (lines.size() < options.batch_size && !stream_->Eof()) {
+                const auto line = stream_->ReadLineView();
+                if (line.empty()) {
+                    break;
+                }
+                lines.push_back(line);
+            }
+            return lines;
+        }
+
+        // Lines of the batch are split into one contiguous range per thread, every
+        // range is decoded into its own arena, documents keep the original order.
+        std::vector<std::shared_ptr<document::Document>> NextBatchParallel() {
+            const auto lines = ReadLineViews();
+            std::vector<std::shared_ptr<document::Document>> res(lines.size());
+            pool_->ForEachRange(lines.size(), [&](std::size_t, std::size_t begin, std::size_t end) {
+                const auto arena = options.use_arena ? std::make_shared<document::Arena>() : nullptr;
+                for (auto i = begin; i < end; ++i) {
+                    res[i] = ReadJsonLine(lines[i], tree_, arena);
+                }
+            });
+            return res;
+        }
+
+        document::CompactBatch NextCompactBatchParallel() {
+            const auto lines = ReadLineViews();
+            document::CompactBatch result;
+            result.arena = std::make_shared<document::Arena>();
+            result.documents.resize(lines.size());
+            std::vector<document::ArenaPtr> arenas(pool_->GetThreadsCount());
+            pool_->ForEachRange(lines.size(), [&](std::size_t part, std::size_t begin, std::size_t end) {
+                arenas[part] = std::make_shared<document::Arena>();
+                document::CompactBuilder builder(arenas[part]);
+                for (auto i = begin; i < end; ++i) {
+                    result.documents[i] = ReadCompactJsonLine(lines[i], tree_, builder);
+                }
+            });
+            for (auto& arena : arenas) {
+                if (arena != nullptr) {
+                    result.arena->Retain(std::move(arena));
+                }
+            }
+            return result;
+        }
+
+        std::shared_ptr<IStream> stream_;
+        TreeNodePtr tree_;
+        std::unique_ptr<ThreadPool> pool_;
+    };
+
+    class JsonWriter: public ChunkWriter {
+    public:
+        JsonWriter(const std::string& path, const ChunkOptions& options)
+            : ChunkWriter(options)
+            , stream_(GetOutputStream(path, options.size_hint, options.durability, options.direct_io))
+            , encoder_(stream_) {
+        }
+
+        void WriteBatch(const std::vector<std::shared_ptr<document::Document>>& documents) override {
+            for (const auto& doc : documents) {
+                encoder_.Encode(std::static_pointer_cast<document::Value>(doc));
+                encoder_.EndLine();
+            }
+        }
+
+        void WriteCompactBatch(const document::CompactBatch& batch) override {
+            for (const auto& doc : batch.documents) {
+                encoder_.Encode(doc);
+                encoder_.EndLine();
+            }
+        }
+
+        bool SupportsCompactBatches() const override {
+            return true;
+        }
+
+        void Finish() override {
+            encoder_.Flush();
+            stream_->Close(options.durability);
+            stream_.reset();
+        }
+
+    private:
+        std::shared_ptr<OStream> stream_;
+        JsonEncoder encoder_;
+    };
 
-        return std::string(buffer.GetString(), buffer.GetSize());
-    }
 } // namespace
 
-void JsonChunk::Write(const std::vector<std::shared_ptr<document::Document>>& documents) const {
-    auto stream = GetOutputStream(path);
+std::unique_ptr<ChunkReader> JsonChunk::CreateReader(const TreeNodePtr& tree, const ChunkOptions& options) const {
+    return std::make_unique<JsonReader>(path, tree, options);
+}
 
-    for (const auto& doc : documents) {
-        auto json = DocumentToJson(doc);
-        stream->Write(json.c_str(), json.size());
-        stream->Write("\n", 1);
-    }
+std::unique_ptr<ChunkWriter> JsonChunk::CreateWriter(const ChunkOptions& options) const {
+    return std::make_unique<JsonWriter>(path, options);
 }
 
 } // namespace lib::chunk_impl
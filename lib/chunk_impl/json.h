@@ -7,12 +7,13 @@ namespace lib::chunk_impl {
 
 class JsonChunk: public Chunk {
 public:
-    JsonChunk(const std::string& path)
-        : Chunk(path) {
+    JsonChunk(const std::string& path, const ChunkOptions& options = {})
+        : Chunk(path, options) {
     }
 
-    std::vector<std::shared_ptr<document::Document>> Read(const TreeNodePtr& tree = TreeNode::Default()) const override;
-    void Write(const std::vector<std::shared_ptr<document::Document>>& documents) const override;
+protected:
+    std::unique_ptr<ChunkReader> CreateReader(const TreeNodePtr& tree, const ChunkOptions& options) const override;
+    std::unique_ptr<ChunkWriter> CreateWriter(const ChunkOptions& options) const override;
 };
 
 } // namespace lib::chunk_impl
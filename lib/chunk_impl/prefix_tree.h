@@ -4,10 +4,12 @@
 #include <memory>
 #include <string>
 
+#include <lib/document/key_table.h>
+
 namespace lib::chunk_impl {
 
 struct TreeNode {
-    std::unordered_map<std::string, std::shared_ptr<TreeNode>> children;
+    std::unordered_map<document::KeyId, std::shared_ptr<TreeNode>> children;
 
     bool IsLeaf() const {
         return children.empty();
@@ -0,0 +1,76 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+
+namespace lib::chunk_impl {
+
+namespace {
+
+    constexpr std::size_t kQueuedTasksPerThread = 4;
+
+} // namespace
+
+ThreadPool::ThreadPool(std::size_t threads_count)
+    : tasks_(std::max<std::size_t>(threads_count, 1) * kQueuedTasksPerThread) {
+    if (threads_count == 0) {
+        throw std::logic_error("Thread pool must have at least one thread");
+    }
+    threads_.reserve(threads_count);
+    for (std::size_t i = 0; i < threads_count; ++i) {
+        threads_.emplace_back([this]() {
+            while (auto task = tasks_.Pop()) {
+                (*task)();
+            }
+        });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    tasks_.Close();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+std::size_t ThreadPool::GetThreadsCount() const {
+    return threads_.size();
+}
+
+std::future<void> ThreadPool::Submit(std::function<void()> task) {
+    std::packaged_task<void()> packaged(std::move(task));
+    auto future = packaged.get_future();
+    if (!tasks_.Push(std::move(packaged))) {
+        throw std::logic_error("Thread pool is stopped");
+    }
+    return future;
+}
+
+void ThreadPool::ForEachRange(std::size_t count, const std::function<void(std::size_t, std::size_t, std::size_t)>& f) {
+    const auto parts = std::min(count, threads_.size());
+    std::vector<std::future<void>> futures;
+    futures.reserve(parts);
+    for (std::size_t part = 0; part < parts; ++part) {
+        const auto begin = count * part / parts;
+        const auto end = count * (part + 1) / parts;
+        futures.push_back(Submit([&f, part, begin, end]() { f(part, begin, end); }));
+    }
+
+    // Every task references f, so all of them are awaited even after a failure.
+    std::exception_ptr error;
+    for (auto& future : futures) {
+        try {
+            future.get();
+        } catch (...) {
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+} // namespace lib::chunk_impl
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include <lib/chunk_impl/bounded_queue.h>
+
+namespace lib::chunk_impl {
+
+// Fixed set of worker threads executing submitted tasks in FIFO order.
+class ThreadPool {
+public:
+    explicit ThreadPool(std::size_t threads_count);
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    // Waits for queued tasks to complete.
+    ~ThreadPool();
+
+    std::size_t GetThreadsCount() const;
+    std::future<void> Submit(std::function<void()> task);
+
+    // Splits [0, count) into at most one contiguous range per thread and calls
+    // f(part, begin, end) for each of them concurrently. Returns once all ranges
+    // are processed, rethrowing the first error.
+    void ForEachRange(std::size_t count, const std::function<void(std::size_t, std::size_t, std::size_t)>& f);
+
+private:
+    BoundedQueue<std::packaged_task<void()>> tasks_;
+    std::vector<std::thread> threads_;
+};
+
+} // namespace lib::chunk_impl
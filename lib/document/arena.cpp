@@ -0,0 +1,41 @@
+#include "arena.h"
+
+namespace lib::document {
+
+Arena::Arena(std::size_t initial_size)
+    : buffer_(initial_size, std::pmr::new_delete_resource()) {
+}
+
+std::size_t Arena::GetAllocationsCount() const {
+    return allocations_count_;
+}
+
+std::size_t Arena::GetAllocatedBytes() const {
+    return allocated_bytes_;
+}
+
+void Arena::Retain(std::shared_ptr<const void> owner) {
+    retained_.push_back(std::move(owner));
+}
+
+void* Arena::do_allocate(std::size_t bytes, std::size_t alignment) {
+    ++allocations_count_;
+    allocated_bytes_ += bytes;
+    return buffer_.allocate(bytes, alignment);
+}
+
+void Arena::do_deallocate(void*, std::size_t, std::size_t) {
+}
+
+bool Arena::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+std::pmr::memory_resource* GetResource(const ArenaPtr& arena) {
+    if (arena == nullptr) {
+        return std::pmr::get_default_resource();
+    }
+    return arena.get();
+}
+
+} // namespace lib::document
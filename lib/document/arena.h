@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+namespace lib::document {
+
+// Bump allocator backing all nodes and strings of a batch of documents.
+// Individual deallocations are no-ops, memory is returned in one go when the
+// arena is destroyed. Not thread-safe: one arena is filled by one decoder.
+class Arena: public std::pmr::memory_resource {
+public:
+    static constexpr std::size_t kDefaultInitialSize = 64 * 1024;
+
+    explicit Arena(std::size_t initial_size = kDefaultInitialSize);
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    std::size_t GetAllocationsCount() const;
+    std::size_t GetAllocatedBytes() const;
+
+    // Keeps owner alive as long as the arena, e.g. mapped input referenced by
+    // borrowed strings of the documents.
+    void Retain(std::shared_ptr<const void> owner);
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    std::pmr::monotonic_buffer_resource buffer_;
+    std::size_t allocations_count_ = 0;
+    std::size_t allocated_bytes_ = 0;
+    std::vector<std::shared_ptr<const void>> retained_;
+};
+
+using ArenaPtr = std::shared_ptr<Arena>;
+
+// Returns arena as memory resource, or the default (heap) resource when arena is not set.
+std::pmr::memory_resource* GetResource(const ArenaPtr& arena);
+
+// Allocator for shared_ptr control blocks. Every copy holds a reference to the arena,
+// so the arena outlives the last node allocated from it.
+template <class T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    ArenaAllocator(const ArenaPtr& arena)
+        : arena_(arena) {
+    }
+
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U>& other)
+        : arena_(other.GetArena()) {
+    }
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T*, std::size_t) {
+    }
+
+    const ArenaPtr& GetArena() const {
+        return arena_;
+    }
+
+    template <class U>
+    bool operator==(const ArenaAllocator<U>& other) const {
+        return arena_ == other.GetArena();
+    }
+
+    template <class U>
+    bool operator!=(const ArenaAllocator<U>& other) const {
+        return arena_ != other.GetArena();
+    }
+
+private:
+    ArenaPtr arena_;
+};
+
+// Creates value in arena if it is set, otherwise on the heap.
+template <class T, class... Args>
+std::shared_ptr<T> MakeValue(const ArenaPtr& arena, Args&&... args) {
+    if (arena == nullptr) {
+        return std::make_shared<T>(std::forward<Args>(args)...);
+    }
+    return std::allocate_shared<T>(ArenaAllocator<T>(arena), std::forward<Args>(args)...);
+}
+
+} // namespace lib::document
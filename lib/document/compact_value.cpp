@@ -0,0 +1,344 @@
+#include "compact_value.h"
+
+#include <stdexcept>
+
+namespace lib::document {
+
+CompactValue::CompactValue()
+    : payload_{}
+    , inline_size_(0)
+    , type_id_(static_cast<uint8_t>(TypeId::kNull)) {
+}
+
+template <class T>
+CompactValue CompactValue::FromScalar(TypeId type_id, T value) {
+    static_assert(sizeof(T) <= kInlineCapacity);
+    CompactValue result;
+    result.type_id_ = static_cast<uint8_t>(type_id);
+    std::memcpy(result.payload_, &value, sizeof(T));
+    return result;
+}
+
+template <class T>
+T CompactValue::GetScalar() const {
+    T value;
+    std::memcpy(&value, payload_, sizeof(T));
+    return value;
+}
+
+CompactValue CompactValue::FromPointer(TypeId type_id, const void* data, uint32_t size) {
+    CompactValue result;
+    result.type_id_ = static_cast<uint8_t>(type_id);
+    std::memcpy(result.payload_, &data, sizeof(data));
+    std::memcpy(result.payload_ + sizeof(data), &size, sizeof(size));
+    return result;
+}
+
+const void* CompactValue::GetPointer() const {
+    return GetScalar<const void*>();
+}
+
+CompactValue CompactValue::Null() {
+    return CompactValue();
+}
+
+CompactValue CompactValue::Boolean(bool value) {
+    return FromScalar(TypeId::kBoolean, value);
+}
+
+CompactValue CompactValue::Int32(int32_t value) {
+    return FromScalar(TypeId::kInt32, value);
+}
+
+CompactValue CompactValue::UInt32(uint32_t value) {
+    return FromScalar(TypeId::kUint32, value);
+}
+
+CompactValue CompactValue::Int64(int64_t value) {
+    return FromScalar(TypeId::kInt64, value);
+}
+
+CompactValue CompactValue::UInt64(uint64_t value) {
+    return FromScalar(TypeId::kUint64, value);
+}
+
+CompactValue CompactValue::Float32(float value) {
+    return FromScalar(TypeId::kFloat32, value);
+}
+
+CompactValue CompactValue::Float64(double value) {
+    return FromScalar(TypeId::kFloat64, value);
+}
+
+CompactValue CompactValue::String(std::string_view value) {
+    if (value.size() > kInlineCapacity) {
+        return FromPointer(TypeId::kString, value.data(), value.size());
+    }
+    CompactValue result;
+    result.type_id_ = static_cast<uint8_t>(TypeId::kString);
+    result.inline_size_ = value.size() + 1;
+    std::memcpy(result.payload_, value.data(), value.size());
+    return result;
+}
+
+CompactValue CompactValue::Document(const CompactField* fields, uint32_t size) {
+    return FromPointer(TypeId::kDocument, fields, size);
+}
+
+CompactValue CompactValue::List(const CompactValue* items, uint32_t size) {
+    return FromPointer(TypeId::kList, items, size);
+}
+
+TypeId CompactValue::GetTypeId() const {
+    return static_cast<TypeId>(type_id_);
+}
+
+bool CompactValue::IsOfPrimitiveType() const {
+    return GetTypeId() < TypeId::kDocument;
+}
+
+bool CompactValue::IsNull() const {
+    return GetTypeId() == TypeId::kNull;
+}
+
+bool CompactValue::GetBoolean() const {
+    return GetScalar<bool>();
+}
+
+int32_t CompactValue::GetInt32() const {
+    return GetScalar<int32_t>();
+}
+
+uint32_t CompactValue::GetUInt32() const {
+    return GetScalar<uint32_t>();
+}
+
+int64_t CompactValue::GetInt64() const {
+    return GetScalar<int64_t>();
+}
+
+uint64_t CompactValue::GetUInt64() const {
+    return GetScalar<uint64_t>();
+}
+
+float CompactValue::GetFloat32() const {
+    return GetScalar<float>();
+}
+
+double CompactValue::GetFloat64() const {
+    return GetScalar<double>();
+}
+
+std::string_view CompactValue::GetString() const {
+    // inline_size_ is stored shifted by one, zero means out-of-line string
+    if (inline_size_ != 0) {
+        return std::string_view(payload_, inline_size_ - 1);
+    }
+    return std::string_view(static_cast<const char*>(GetPointer()), Size());
+}
+
+uint32_t CompactValue::Size() const {
+    uint32_t size;
+    std::memcpy(&size, payload_ + sizeof(void*), sizeof(size));
+    return size;
+}
+
+const CompactField* CompactValue::FieldsBegin() const {
+    return static_cast<const CompactField*>(GetPointer());
+}
+
+const CompactField* CompactValue::FieldsEnd() const {
+    return FieldsBegin() + Size();
+}
+
+const CompactValue* CompactValue::ItemsBegin() const {
+    return static_cast<const CompactValue*>(GetPointer());
+}
+
+const CompactValue* CompactValue::ItemsEnd() const {
+    return ItemsBegin() + Size();
+}
+
+const CompactValue* CompactValue::Find(KeyId key) const {
+    for (auto it = FieldsBegin(); it != FieldsEnd(); ++it) {
+        if (it->key == key) {
+            return &it->value;
+        }
+    }
+    return nullptr;
+}
+
+const CompactValue* CompactValue::Find(std::string_view key) const {
+    const auto id = KeyTable::Global().Find(key);
+    if (!id) {
+        return nullptr;
+    }
+    return Find(*id);
+}
+
+CompactBuilder::CompactBuilder(const ArenaPtr& arena)
+    : arena_(arena) {
+    if (arena_ == nullptr) {
+        throw std::logic_error("CompactBuilder requires arena");
+    }
+}
+
+const ArenaPtr& CompactBuilder::GetArena() const {
+    return arena_;
+}
+
+std::string_view CompactBuilder::CopyToArena(std::string_view value) {
+    if (value.empty()) {
+        return {};
+    }
+    auto data = static_cast<char*>(arena_->allocate(value.size(), 1));
+    std::memcpy(data, value.data(), value.size());
+    return std::string_view(data, value.size());
+}
+
+CompactValue CompactBuilder::MakeString(std::string_view value) {
+    if (value.size() <= CompactValue::kInlineCapacity) {
+        return CompactValue::String(value);
+    }
+    return CompactValue::String(CopyToArena(value));
+}
+
+CompactValue CompactBuilder::MakeBorrowedString(std::string_view value) {
+    return CompactValue::String(value);
+}
+
+std::size_t CompactBuilder::StartDocument() {
+    return fields_.size();
+}
+
+void CompactBuilder::AddField(KeyId key, const CompactValue& value) {
+    fields_.push_back(CompactField{key, value});
+}
+
+CompactValue CompactBuilder::FinishDocument(std::size_t mark) {
+    const auto size = fields_.size() - mark;
+    auto fields = static_cast<CompactField*>(arena_->allocate(size * sizeof(CompactField), alignof(CompactField)));
+    std::uninitialized_copy(fields_.begin() + mark, fields_.end(), fields);
+    fields_.resize(mark);
+    return CompactValue::Document(fields, size);
+}
+
+std::size_t CompactBuilder::StartList() {
+    return items_.size();
+}
+
+void CompactBuilder::AddItem(const CompactValue& value) {
+    items_.push_back(value);
+}
+
+CompactValue CompactBuilder::FinishList(std::size_t mark) {
+    const auto size = items_.size() - mark;
+    auto items = static_cast<CompactValue*>(arena_->allocate(size * sizeof(CompactValue), alignof(CompactValue)));
+    std::uninitialized_copy(items_.begin() + mark, items_.end(), items);
+    items_.resize(mark);
+    return CompactValue::List(items, size);
+}
+
+CompactValue ToCompactValue(const std::shared_ptr<Value>& value, CompactBuilder& builder) {
+    switch (value->GetTypeId()) {
+        case TypeId::kNull:
+            return CompactValue::Null();
+        case TypeId::kBoolean:
+            return CompactValue::Boolean(std::static_pointer_cast<document::Boolean>(value)->value);
+        case TypeId::kInt32:
+            return CompactValue::Int32(std::static_pointer_cast<document::Int32>(value)->value);
+        case TypeId::kUint32:
+            return CompactValue::UInt32(std::static_pointer_cast<document::UInt32>(value)->value);
+        case TypeId::kInt64:
+            return CompactValue::Int64(std::static_pointer_cast<document::Int64>(value)->value);
+        case TypeId::kUint64:
+            return CompactValue::UInt64(std::static_pointer_cast<document::UInt64>(value)->value);
+        case TypeId::kFloat32:
+            return CompactValue::Float32(std::static_pointer_cast<document::Float32>(value)->value);
+        case TypeId::kFloat64:
+            return CompactValue::Float64(std::static_pointer_cast<document::Float64>(value)->value);
+        case TypeId::kString:
+            return builder.MakeString(std::static_pointer_cast<document::String>(value)->value);
+        case TypeId::kDocument: {
+            const auto mark = builder.StartDocument();
+            for (const auto& [k, v] : std::static_pointer_cast<document::Document>(value)->value) {
+                builder.AddField(k, ToCompactValue(v, builder));
+            }
+            return builder.FinishDocument(mark);
+        }
+        case TypeId::kList: {
+            const auto mark = builder.StartList();
+            for (const auto& v : std::static_pointer_cast<document::List>(value)->value) {
+                builder.AddItem(ToCompactValue(v, builder));
+            }
+            return builder.FinishList(mark);
+        }
+        default:
+            throw std::logic_error("Unreachable code");
+    }
+}
+
+std::shared_ptr<Value> FromCompactValue(const CompactValue& value, const ArenaPtr& arena) {
+    auto resource = GetResource(arena);
+
+    switch (value.GetTypeId()) {
+        case TypeId::kNull:
+            return MakeValue<document::Null>(arena);
+        case TypeId::kBoolean:
+            return MakeValue<document::Boolean>(arena, value.GetBoolean());
+        case TypeId::kInt32:
+            return MakeValue<document::Int32>(arena, value.GetInt32());
+        case TypeId::kUint32:
+            return MakeValue<document::UInt32>(arena, value.GetUInt32());
+        case TypeId::kInt64:
+            return MakeValue<document::Int64>(arena, value.GetInt64());
+        case TypeId::kUint64:
+            return MakeValue<document::UInt64>(arena, value.GetUInt64());
+        case TypeId::kFloat32:
+            return MakeValue<document::Float32>(arena, value.GetFloat32());
+        case TypeId::kFloat64:
+            return MakeValue<document::Float64>(arena, value.GetFloat64());
+        case TypeId::kString:
+            return MakeValue<document::String>(arena, value.GetString(), resource);
+        case TypeId::kDocument: {
+            ValueMap map(resource);
+            map.reserve(value.Size());
+            for (auto it = value.FieldsBegin(); it != value.FieldsEnd(); ++it) {
+                map[it->key] = FromCompactValue(it->value, arena);
+            }
+            return MakeValue<document::Document>(arena, std::move(map));
+        }
+        case TypeId::kList: {
+            ValueList list(resource);
+            list.reserve(value.Size());
+            for (auto it = value.ItemsBegin(); it != value.ItemsEnd(); ++it) {
+                list.push_back(FromCompactValue(*it, arena));
+            }
+            return MakeValue<document::List>(arena, std::move(list));
+        }
+        default:
+            throw std::logic_error("Unreachable code");
+    }
+}
+
+CompactBatch ToCompactBatch(const std::vector<std::shared_ptr<document::Document>>& documents) {
+    CompactBatch batch;
+    batch.arena = std::make_shared<Arena>();
+    CompactBuilder builder(batch.arena);
+    batch.documents.reserve(documents.size());
+    for (const auto& doc : documents) {
+        batch.documents.push_back(ToCompactValue(doc, builder));
+    }
+    return batch;
+}
+
+std::vector<std::shared_ptr<document::Document>> FromCompactBatch(const CompactBatch& batch, const ArenaPtr& arena) {
+    std::vector<std::shared_ptr<document::Document>> documents;
+    documents.reserve(batch.documents.size());
+    for (const auto& doc : batch.documents) {
+        documents.push_back(std::static_pointer_cast<document::Document>(FromCompactValue(doc, arena)));
+    }
+    return documents;
+}
+
+} // namespace lib::document
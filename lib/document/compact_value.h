@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "arena.h"
+#include "document.h"
+
+namespace lib::document {
+
+struct CompactField;
+
+// 16-byte tagged union alternative to the Value hierarchy. Scalars and strings
+// up to kInlineCapacity bytes are stored inline, longer strings and children of
+// documents/lists live in contiguous arrays owned by an Arena.
+class CompactValue {
+public:
+    static constexpr std::size_t kInlineCapacity = 14;
+
+    CompactValue();
+
+    static CompactValue Null();
+    static CompactValue Boolean(bool value);
+    static CompactValue Int32(int32_t value);
+    static CompactValue UInt32(uint32_t value);
+    static CompactValue Int64(int64_t value);
+    static CompactValue UInt64(uint64_t value);
+    static CompactValue Float32(float value);
+    static CompactValue Float64(double value);
+    // Keeps pointer to data, which must outlive the value if it is not inlined.
+    static CompactValue String(std::string_view value);
+    static CompactValue Document(const CompactField* fields, uint32_t size);
+    static CompactValue List(const CompactValue* items, uint32_t size);
+
+    TypeId GetTypeId() const;
+    bool IsOfPrimitiveType() const;
+    bool IsNull() const;
+
+    bool GetBoolean() const;
+    int32_t GetInt32() const;
+    uint32_t GetUInt32() const;
+    int64_t GetInt64() const;
+    uint64_t GetUInt64() const;
+    float GetFloat32() const;
+    double GetFloat64() const;
+    std::string_view GetString() const;
+
+    const CompactField* FieldsBegin() const;
+    const CompactField* FieldsEnd() const;
+    const CompactValue* ItemsBegin() const;
+    const CompactValue* ItemsEnd() const;
+    uint32_t Size() const;
+
+    // Linear search, documents are expected to be small.
+    const CompactValue* Find(KeyId key) const;
+    const CompactValue* Find(std::string_view key) const;
+
+private:
+    template <class T>
+    static CompactValue FromScalar(TypeId type_id, T value);
+    template <class T>
+    T GetScalar() const;
+    static CompactValue FromPointer(TypeId type_id, const void* data, uint32_t size);
+    const void* GetPointer() const;
+
+    alignas(8) char payload_[kInlineCapacity];
+    uint8_t inline_size_;
+    uint8_t type_id_;
+};
+
+static_assert(sizeof(CompactValue) == 16, "CompactValue must stay 16 bytes");
+
+struct CompactField {
+    KeyId key;
+    CompactValue value;
+};
+
+// Builds compact trees into arena. Children of unfinished documents and lists
+// are kept on shared scratch stacks and copied into arena once complete.
+class CompactBuilder {
+public:
+    explicit CompactBuilder(const ArenaPtr& arena);
+
+    CompactValue MakeString(std::string_view value);
+    // Long strings keep pointing to value, its memory must outlive the arena
+    // (see Arena::Retain).
+    CompactValue MakeBorrowedString(std::string_view value);
+
+    std::size_t StartDocument();
+    void AddField(KeyId key, const CompactValue& value);
+    CompactValue FinishDocument(std::size_t mark);
+
+    std::size_t StartList();
+    void AddItem(const CompactValue& value);
+    CompactValue FinishList(std::size_t mark);
+
+    const ArenaPtr& GetArena() const;
+
+private:
+    std::string_view CopyToArena(std::string_view value);
+
+    ArenaPtr arena_;
+    std::vector<CompactField> fields_;
+    std::vector<CompactValue> items_;
+};
+
+// Compact documents together with the arena owning their memory.
+struct CompactBatch {
+    ArenaPtr arena;
+    std::vector<CompactValue> documents;
+};
+
+CompactValue ToCompactValue(const std::shared_ptr<Value>& value, CompactBuilder& builder);
+std::shared_ptr<Value> FromCompactValue(const CompactValue& value, const ArenaPtr& arena = nullptr);
+
+CompactBatch ToCompactBatch(const std::vector<std::shared_ptr<document::Document>>& documents);
+std::vector<std::shared_ptr<document::Document>> FromCompactBatch(const CompactBatch& batch, const ArenaPtr& arena = nullptr);
+
+} // namespace lib::document
@@ -86,18 +86,124 @@ Float64::Float64(double value)
     , value(value) {
 }
 
-String::String(const std::string& value)
+String::String(std::string_view value, std::pmr::memory_resource* resource)
     : Value(TypeId::kString)
-    , value(value) {
+    , storage_(value, resource)
+    , value(storage_) {
 }
 
-String::String(std::string&& value)
+String::String(std::pmr::string&& value)
     : Value(TypeId::kString)
-    , value(std::move(value)) {
+    , storage_(std::move(value))
+    , value(storage_) {
+}
+
+String::String(std::string_view value, BorrowedTag)
+    : Value(TypeId::kString)
+    , storage_(std::pmr::null_memory_resource())
+    , value(value) {
+}
+
+ValueMap::ValueMap(std::pmr::memory_resource* resource)
+    : fields_(resource)
+    , index_(resource) {
+}
+
+ValueMap::iterator ValueMap::find(KeyId key) {
+    if (!index_.empty()) {
+        const auto it = index_.find(key);
+        return it == index_.end() ? fields_.end() : fields_.begin() + it->second;
+    }
+    auto it = fields_.begin();
+    while (it != fields_.end() && it->key != key) {
+        ++it;
+    }
+    return it;
+}
+
+ValueMap::const_iterator ValueMap::find(KeyId key) const {
+    if (!index_.empty()) {
+        const auto it = index_.find(key);
+        return it == index_.end() ? fields_.end() : fields_.begin() + it->second;
+    }
+    auto it = fields_.begin();
+    while (it != fields_.end() && it->key != key) {
+        ++it;
+    }
+    return it;
 }
 
-Document::Document()
-    : Value(TypeId::kDocument) {
+ValueMap::const_iterator ValueMap::find(std::string_view key) const {
+    const auto id = KeyTable::Global().Find(key);
+    if (!id) {
+        return fields_.end();
+    }
+    return find(*id);
+}
+
+std::shared_ptr<Value>& ValueMap::operator[](KeyId key) {
+    auto it = find(key);
+    if (it != fields_.end()) {
+        return it->value;
+    }
+    return Append(key, nullptr).value;
+}
+
+void ValueMap::emplace(KeyId key, std::shared_ptr<Value> value) {
+    auto it = find(key);
+    if (it != fields_.end()) {
+        return;
+    }
+    Append(key, std::move(value));
+}
+
+Field& ValueMap::Append(KeyId key, std::shared_ptr<Value> value) {
+    auto& field = fields_.emplace_back(Field{key, std::move(value)});
+    if (!index_.empty()) {
+        index_.emplace(key, fields_.size() - 1);
+    } else if (fields_.size() > kIndexThreshold) {
+        index_.reserve(fields_.capacity());
+        for (std::size_t i = 0; i < fields_.size(); ++i) {
+            index_.emplace(fields_[i].key, i);
+        }
+    }
+    return field;
+}
+
+ValueMap::iterator ValueMap::begin() {
+    return fields_.begin();
+}
+
+ValueMap::iterator ValueMap::end() {
+    return fields_.end();
+}
+
+ValueMap::const_iterator ValueMap::begin() const {
+    return fields_.begin();
+}
+
+ValueMap::const_iterator ValueMap::end() const {
+    return fields_.end();
+}
+
+std::size_t ValueMap::size() const {
+    return fields_.size();
+}
+
+bool ValueMap::empty() const {
+    return fields_.empty();
+}
+
+void ValueMap::reserve(std::size_t size) {
+    fields_.reserve(size);
+    if (size > kIndexThreshold) {
+        index_.reserve(size);
+    }
+}
+
+Document::Document(std::pmr::memory_resource* resource)
+    : Value(TypeId::kDocument)
+    , value(resource) {
 }
 
 Document::Document(const ValueMap& value)
@@ -110,8 +216,9 @@ Document::Document(ValueMap&& value)
     , value(std::move(value)) {
 }
 
-List::List()
-    : Value(TypeId::kList) {
+List::List(std::pmr::memory_resource* resource)
+    : Value(TypeId::kList)
+    , value(resource) {
 }
 
 List::List(const ValueList& value)
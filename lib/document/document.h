@@ -1,11 +1,15 @@
 #pragma once
 
-#include <unordered_map>
 #include <cstdint>
 #include <memory>
+#include <memory_resource>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
+#include "key_table.h"
+
 namespace lib::document {
 
 enum class TypeId {
@@ -82,29 +86,85 @@ public:
     Float64(double value);
 };
 
+// Marks string values that reference bytes owned elsewhere (e.g. mmapped input
+// retained by the arena of the batch) instead of copying them.
+struct BorrowedTag {};
+inline constexpr BorrowedTag kBorrowed{};
+
+// Containers below take memory resource, so that whole document tree
+// (including strings) can be placed into document::Arena.
 class String: public Value {
+private:
+    std::pmr::string storage_;
+
 public:
-    std::string value;
-    String(const std::string& value);
-    String(std::string&& value);
+    // Points either into storage_ or into borrowed memory.
+    std::string_view value;
+
+    String(std::string_view value, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+    String(std::pmr::string&& value);
+    String(std::string_view value, BorrowedTag);
+    String(const String&) = delete;
+    String& operator=(const String&) = delete;
 };
 
-using ValueMap = std::unordered_map<std::string, std::shared_ptr<document::Value>>;
+struct Field {
+    KeyId key;
+    std::shared_ptr<Value> value;
+};
+
+// Fields of a document in insertion order, which is schema order for documents
+// assembled from columnar chunks. Keys are interned, so lookups in small
+// documents scan integer ids instead of hashing strings. Wide documents also
+// index positions of fields by key, so building them stays linear.
+class ValueMap {
+public:
+    using Storage = std::pmr::vector<Field>;
+    using iterator = Storage::iterator;
+    using const_iterator = Storage::const_iterator;
+
+    ValueMap(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    iterator find(KeyId key);
+    const_iterator find(KeyId key) const;
+    // Keys never interned can not be present, so no registration happens here.
+    const_iterator find(std::string_view key) const;
+    // Appends null pointer if key is absent.
+    std::shared_ptr<Value>& operator[](KeyId key);
+    void emplace(KeyId key, std::shared_ptr<Value> value);
+
+    iterator begin();
+    iterator end();
+    const_iterator begin() const;
+    const_iterator end() const;
+    std::size_t size() const;
+    bool empty() const;
+    void reserve(std::size_t size);
+
+private:
+    static constexpr std::size_t kIndexThreshold = 32;
+
+    Storage fields_;
+    // Empty until the document has more than kIndexThreshold fields.
+    std::pmr::unordered_map<KeyId, std::uint32_t> index_;
+
+    Field& Append(KeyId key, std::shared_ptr<Value> value);
+};
 
 class Document: public Value {
 public:
     ValueMap value;
-    Document();
+    Document(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
     Document(const ValueMap& value);
     Document(ValueMap&& value);
 };
 
-using ValueList = std::vector<std::shared_ptr<Value>>;
+using ValueList = std::pmr::vector<std::shared_ptr<Value>>;
 
 class List: public Value {
 public:
     ValueList value;
-    List();
+    List(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
     List(const ValueList& value);
     List(ValueList&& value);
 };
@@ -0,0 +1,103 @@
+#include "key_table.h"
+
+#include <mutex>
+#include <stdexcept>
+
+namespace lib::document {
+
+namespace {
+
+    // Ids are never invalidated, so every thread can remember the keys it has
+    // seen and skip the shared lock of the table, which parallel decoders contend on.
+    std::unordered_map<std::string_view, KeyId>& ThreadKeyCache() {
+        thread_local std::unordered_map<std::string_view, KeyId> cache;
+        return cache;
+    }
+
+} // namespace
+
+KeyTable& KeyTable::Global() {
+    static KeyTable table;
+    return table;
+}
+
+KeyTable::KeyTable() {
+}
+
+KeyId KeyTable::Intern(std::string_view key) {
+    {
+        std::shared_lock lock(mutex_);
+        const auto it = ids_.find(key);
+        if (it != ids_.end()) {
+            return it->second;
+        }
+    }
+
+    std::unique_lock lock(mutex_);
+    const auto it = ids_.find(key);
+    if (it != ids_.end()) {
+        return it->second;
+    }
+
+    const auto id = size_;
+    const auto block = id >> kBlockBits;
+    if (block >= kMaxBlocks) {
+        throw std::runtime_error("Too many distinct document keys");
+    }
+    if (blocks_[block] == nullptr) {
+        blocks_[block] = std::make_unique<std::string[]>(kBlockSize);
+    }
+
+    auto& stored = blocks_[block][id & (kBlockSize - 1)];
+    stored = std::string(key);
+    ids_.emplace(stored, id);
+    ++size_;
+    return id;
+}
+
+std::optional<KeyId> KeyTable::Find(std::string_view key) const {
+    std::shared_lock lock(mutex_);
+    const auto it = ids_.find(key);
+    if (it == ids_.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+const std::string& KeyTable::GetKey(KeyId id) const {
+    return blocks_[id >> kBlockBits][id & (kBlockSize - 1)];
+}
+
+KeyId InternKey(std::string_view key) {
+    auto& cache = ThreadKeyCache();
+    const auto it = cache.find(key);
+    if (it != cache.end()) {
+        return it->second;
+    }
+
+    auto& table = KeyTable::Global();
+    const auto id = table.Intern(key);
+    cache.emplace(table.GetKey(id), id);
+    return id;
+}
+
+std::optional<KeyId> FindKey(std::string_view key) {
+    auto& cache = ThreadKeyCache();
+    const auto it = cache.find(key);
+    if (it != cache.end()) {
+        return it->second;
+    }
+
+    auto& table = KeyTable::Global();
+    const auto id = table.Find(key);
+    if (id) {
+        cache.emplace(table.GetKey(*id), *id);
+    }
+    return id;
+}
+
+const std::string& KeyName(KeyId id) {
+    return KeyTable::Global().GetKey(id);
+}
+
+} // namespace lib::document
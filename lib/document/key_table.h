@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace lib::document {
+
+using KeyId = std::uint32_t;
+
+// Process-wide dictionary of document keys. Each distinct key is stored once
+// and referenced by id afterwards. Ids and key references are never invalidated,
+// so readers of a known id need no locking.
+class KeyTable {
+public:
+    static KeyTable& Global();
+
+    KeyTable();
+    KeyTable(const KeyTable&) = delete;
+    KeyTable& operator=(const KeyTable&) = delete;
+
+    KeyId Intern(std::string_view key);
+    // Does not register unknown keys.
+    std::optional<KeyId> Find(std::string_view key) const;
+    const std::string& GetKey(KeyId id) const;
+
+private:
+    static constexpr std::size_t kBlockBits = 12;
+    static constexpr std::size_t kBlockSize = 1 << kBlockBits;
+    static constexpr std::size_t kMaxBlocks = 1 << 14;
+
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::string_view, KeyId> ids_;
+    std::array<std::unique_ptr<std::string[]>, kMaxBlocks> blocks_;
+    KeyId size_ = 0;
+};
+
+KeyId InternKey(std::string_view key);
+// Like KeyTable::Find, through the cache of InternKey. Unknown keys are not
+// registered, e.g. keys skipped by projection.
+std::optional<KeyId> FindKey(std::string_view key);
+const std::string& KeyName(KeyId id);
+
+} // namespace lib::document
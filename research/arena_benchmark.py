@@ -0,0 +1,53 @@
+import argparse
+import statistics
+
+from runner import run_read
+
+
+def benchmark(binary, path, format, schema_path, repeats):
+    results = {}
+    for use_arena in [False, True]:
+        durations = []
+        allocations = []
+        for _ in range(repeats):
+            stats = run_read(
+                binary, path, format, schema_path=schema_path, use_arena=use_arena
+            )
+            if "allocations" not in stats:
+                raise SystemExit(
+                    "The binary does not count allocations, "
+                    "build it with -DCOUNT_ALLOCATIONS=ON"
+                )
+            durations.append(stats["read_duration_ns"])
+            allocations.append(stats["allocations"])
+        results["arena" if use_arena else "heap"] = {
+            "read_duration_ns": statistics.median(durations),
+            "allocations": statistics.median(allocations),
+        }
+    return results
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(
+        description="Compares decoding with heap-allocated and arena-allocated documents."
+    )
+    parser.add_argument("--binary", required=True)
+    parser.add_argument("--path", required=True)
+    parser.add_argument("--format", required=True)
+    parser.add_argument("--schema-path")
+    parser.add_argument("--repeats", type=int, default=5)
+    args = parser.parse_args()
+
+    results = benchmark(
+        args.binary, args.path, args.format, args.schema_path, args.repeats
+    )
+    for mode, stats in results.items():
+        print(
+            f"{mode}: read_duration_ns={stats['read_duration_ns']:.0f} "
+            f"allocations={stats['allocations']:.0f}"
+        )
+    heap, arena = results["heap"], results["arena"]
+    print(
+        f"allocations x{heap['allocations'] / max(arena['allocations'], 1):.1f} fewer, "
+        f"decode x{heap['read_duration_ns'] / arena['read_duration_ns']:.2f} faster"
+    )
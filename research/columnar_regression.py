@@ -0,0 +1,94 @@
+import argparse
+import json
+import os
+import tempfile
+
+from runner import run_cli
+
+# Page headers start with the little-endian row count, so pages of 255 rows
+# (mod 256) start with a 0xFF byte. Streams without views, e.g. with
+# --direct-io, once mistook it for the end of the column.
+CASES = [
+    {"docs_count": 255, "layout": "directory", "row_group_size": 0},
+    {"docs_count": 511, "layout": "directory", "row_group_size": 0},
+    {"docs_count": 2000, "layout": "file", "row_group_size": 500},
+]
+
+
+def read_records(binary, path, schema_path, direct_io):
+    command = [
+        binary,
+        "read",
+        "--path",
+        path,
+        "--format",
+        "columnar",
+        "--schema-path",
+        schema_path,
+        "--write-to-stdout",
+        "true",
+        "--direct-io",
+        "true" if direct_io else "false",
+    ]
+    stdout, _ = run_cli(command)
+    if stdout is None:
+        return None
+    return [json.loads(line) for line in stdout.splitlines()]
+
+
+def check(binary, directory, case):
+    schema_path = os.path.join(directory, "schema.json")
+    with open(schema_path, "w") as f:
+        json.dump({"a": "int"}, f)
+    input_path = os.path.join(directory, f"input-{case['docs_count']}.json")
+    expected = [{"a": i} for i in range(case["docs_count"])]
+    with open(input_path, "w") as f:
+        for doc in expected:
+            f.write(json.dumps(doc) + "\n")
+
+    output_path = os.path.join(directory, f"output-{case['docs_count']}-{case['layout']}")
+    run_cli(
+        [
+            binary,
+            "transform",
+            "--input-path",
+            input_path,
+            "--input-format",
+            "json",
+            "--output-path",
+            output_path,
+            "--output-format",
+            "columnar",
+            "--schema-path",
+            schema_path,
+            "--columnar-layout",
+            case["layout"],
+            "--row-group-size",
+            str(case["row_group_size"]),
+        ]
+    )
+
+    ok = True
+    for direct_io in [False, True]:
+        records = read_records(binary, output_path, schema_path, direct_io)
+        passed = records == expected
+        ok = ok and passed
+        print(
+            f"{case['layout']} docs={case['docs_count']} direct_io={direct_io}: "
+            f"{'ok' if passed else 'FAILED'} "
+            f"({len(records) if records is not None else 'error'} records)"
+        )
+    return ok
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(
+        description="Reads back columnar chunks whose pages start with 0xFF bytes."
+    )
+    parser.add_argument("--binary", required=True)
+    args = parser.parse_args()
+
+    with tempfile.TemporaryDirectory() as directory:
+        results = [check(args.binary, directory, case) for case in CASES]
+    if not all(results):
+        raise SystemExit(1)
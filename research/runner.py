@@ -45,7 +45,9 @@ def run_transform(
     return json.loads(stderr)
 
 
-def run_read(binary, path, format, *, schema_path=None, partial_request=[]):
+def run_read(
+    binary, path, format, *, schema_path=None, partial_request=[], use_arena=True
+):
     command = [binary, "read", "--path", path, "--format", format]
     if len(partial_request) > 0:
         command.append("--columns")
@@ -53,6 +55,8 @@ def run_read(binary, path, format, *, schema_path=None, partial_request=[]):
     if schema_path is not None:
         command.append("--schema-path")
         command.append(schema_path)
+    command.append("--use-arena")
+    command.append("true" if use_arena else "false")
 
     _, stderr = run_cli(command)
     return json.loads(stderr)